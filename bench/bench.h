@@ -0,0 +1,23 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* Helpers for the benchmarks of dini                                                                        *
+************************************************************************************************************/
+
+#include <string>
+#include <functional>
+
+// Get the time run takes in seconds, the best of runs runs (before each run, prepare is called, which isn't timed)
+double bestTime(const std::function<void()>& run, const int& runs=5, const std::function<void()>& prepare=std::function<void()>());
+// Print the time a benchmark took
+void report(const std::string& name, const double& seconds);
+
+// The benchmarks, each in a file of its own
+void benchIo();
+void benchAccess();
+#endif // BENCH_H
@@ -0,0 +1,25 @@
+#-------------------------------------------------
+#
+# Benchmarks of dini, "make benchmark" in the build of dini.pro builds and runs them
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = bench
+CONFIG   += console c++11 release
+CONFIG   -= app_bundle debug
+
+TEMPLATE = app
+
+
+SOURCES += main.cpp \
+    bench_io.cpp \
+    bench_access.cpp
+
+HEADERS += bench.h
+
+include(../dini.pri)
+
+# Load and save through io_uring (when the kernel has it), to compare it with the iostreams
+linux: DEFINES += DINI_USE_IO_URING
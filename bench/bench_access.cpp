@@ -0,0 +1,66 @@
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* Benchmarks of lookups with access counting off (which should cost next to nothing) and on                 *
+************************************************************************************************************/
+
+#include "bench.h"
+#include "dini.h"
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace dini;
+
+namespace
+{
+    const int sectionCount=200, valueCount=50, rounds=50;
+
+    // Look up every value of every section rounds times, as a program reading its settings on a hot path does
+    void lookUp(const iniFile& file, const vector<string>& sections, const vector<string>& values)
+    {
+        size_t found=0;
+        for(int round=0; round<rounds; round++)
+        {
+            for(vector<string>::const_iterator section=sections.begin(); section!=sections.end(); ++section)
+            {
+                const iniSection* current=file.tryGetSection(*section);
+                for(vector<string>::const_iterator value=values.begin(); value!=values.end(); ++value)
+                    found+=current->tryGetValue(*value)!=0;
+            }
+        }
+        if(found!=static_cast<size_t>(rounds)*sections.size()*values.size())
+            cout<<"  not all values were found"<<endl;
+    }
+}
+
+void benchAccess()
+{
+    iniFile file;
+    vector<string> sections, values;
+    for(int section=0; section<sectionCount; section++)
+        sections.push_back("section"+to_string(section));
+    for(int value=0; value<valueCount; value++)
+        values.push_back("value"+to_string(value));
+    for(vector<string>::const_iterator section=sections.begin(); section!=sections.end(); ++section)
+    {
+        for(vector<string>::const_iterator value=values.begin(); value!=values.end(); ++value)
+            file[*section].setValue(*value, 1);
+    }
+    const double lookups=static_cast<double>(rounds)*sectionCount*(valueCount+1);
+    cout<<"  "<<lookups/1e6<<" million lookups each"<<endl;
+
+    // With counting off, the only difference with a file that never counted is a check for a null pointer per lookup
+    const double never=bestTime([&]() { lookUp(file, sections, values); });
+    report("never counted", never);
+    file.setAccessCounting(true);
+    const double counting=bestTime([&]() { lookUp(file, sections, values); });
+    report("counting", counting);
+    file.setAccessCounting(false);
+    const double off=bestTime([&]() { lookUp(file, sections, values); });
+    report("counting turned off again", off);
+    cout<<"  overhead per lookup: "<<(counting-never)/lookups*1e9<<" ns counting, "<<(off-never)/lookups*1e9<<" ns turned off"<<endl;
+}
@@ -0,0 +1,105 @@
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* Benchmarks of reading and writing whole files, compared with iostreams, on a cold and a warm page cache   *
+************************************************************************************************************/
+
+#include "bench.h"
+#include "dini.h"
+#include "dini_io.h"
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define BENCH_COLD_CACHE
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+using namespace std;
+using namespace dini;
+
+namespace
+{
+    const string path="dini_bench_io.ini";
+
+    // Remove the file from the page cache, so the next read comes from the disk (where the system allows that)
+    void dropFromCache()
+    {
+#if defined(BENCH_COLD_CACHE) && defined(POSIX_FADV_DONTNEED)
+        const int fd=::open(path.c_str(), O_RDONLY);
+        if(fd<0)
+            return;
+        ::fsync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+#endif
+    }
+
+    void readStream()
+    {
+        ifstream file(path.c_str(), ios_base::in | ios_base::binary);
+        const string data((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    }
+    void readWhole()
+    {
+        string data;
+        diniPrivate::readWholeFile(path, data);
+    }
+}
+
+void benchIo()
+{
+    // A file of about 30 MB, with lines of different lengths
+    iniFile file;
+    for(int section=0; section<2000; section++)
+    {
+        for(int value=0; value<200; value++)
+            file["section"+to_string(section)].setValue("value"+to_string(value), string(value%150, 'x')+to_string(section*value));
+    }
+    file.saveToFile(path);
+    string data;
+    diniPrivate::readWholeFile(path, data);
+    cout<<"  file of "<<data.size()/(1<<20)<<" MB"<<endl;
+
+    // Reading the whole file, from the disk and from the page cache
+    report("read, cold cache, iostream", bestTime(readStream, 3, dropFromCache));
+    report("read, cold cache, dini_io", bestTime(readWhole, 3, dropFromCache));
+    report("read, warm cache, iostream", bestTime(readStream));
+    report("read, warm cache, dini_io", bestTime(readWhole));
+
+    // Writing it line by line, as saveToFile() does
+    report("write, iostream", bestTime([&data]()
+    {
+        ofstream out(path.c_str(), ofstream::out | ofstream::trunc | ofstream::binary);
+        for(size_t pos=0; pos<data.size(); )
+        {
+            const size_t end=min(data.find('\n', pos), data.size()-1)+1;
+            out.write(data.data()+pos, end-pos);
+            pos=end;
+        }
+    }));
+    report("write, dini_io", bestTime([&data]()
+    {
+        diniPrivate::fileWriter out;
+        out.open(path);
+        for(size_t pos=0; pos<data.size(); )
+        {
+            const size_t end=min(data.find('\n', pos), data.size()-1)+1;
+            out.write(data.data()+pos, end-pos);
+            pos=end;
+        }
+        out.close();
+    }));
+
+    // Loading and saving the whole file, which includes parsing and formatting it
+    report("loadFromFile, cold cache", bestTime([]() { iniFile loaded; loaded.loadFromFile(path); }, 3, dropFromCache));
+    report("loadFromFile, warm cache", bestTime([]() { iniFile loaded; loaded.loadFromFile(path); }));
+    report("saveToFile", bestTime([&file]() { file.saveToFile(path); }));
+    remove(path.c_str());
+}
@@ -0,0 +1,58 @@
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* Runs the benchmarks of dini, all of them or the ones named on the command line                            *
+************************************************************************************************************/
+
+#include "bench.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+
+double bestTime(const function<void()>& run, const int& runs, const function<void()>& prepare)
+{
+    double best=0;
+    for(int i=0; i<runs; i++)
+    {
+        if(prepare)
+            prepare();
+        const chrono::steady_clock::time_point start=chrono::steady_clock::now();
+        run();
+        const double seconds=chrono::duration<double>(chrono::steady_clock::now()-start).count();
+        if(i==0 || seconds<best)
+            best=seconds;
+    }
+    return best;
+}
+
+void report(const string& name, const double& seconds)
+{ cout<<"  "<<left<<setw(48)<<name<<fixed<<setprecision(2)<<seconds*1000<<" ms"<<endl; }
+
+int main(int argc, char** argv)
+{
+    struct benchmark
+    {
+        const char* name;
+        void (*run)();
+    };
+    const benchmark benchmarks[]={
+        { "io", benchIo },
+        { "access", benchAccess }
+    };
+    for(size_t i=0; i<sizeof(benchmarks)/sizeof(benchmarks[0]); i++)
+    {
+        bool selected=(argc==1);
+        for(int arg=1; arg<argc; arg++)
+            selected=selected || std::strcmp(argv[arg], benchmarks[i].name)==0;
+        if(!selected)
+            continue;
+        cout<<benchmarks[i].name<<':'<<endl;
+        benchmarks[i].run();
+    }
+    return 0;
+}
@@ -18,6 +18,8 @@
 * Everything in this library is put in the namespace dini:: (which is the name of this library).            *
 * You don't need any other libraries for this library,                                                      *
 * except for the standard library of course, which is distributed with every C++ implementation.            *
+* The library uses C++11 (for example for the asynchronous loading and saving), so make sure your compiler  *
+* is set to C++11 or C++14.                                                                                 *
 * Just add all the *.h and *.cpp files to your project,                                                     *
 * include dini.h where you need to use this library and you're ready to go!                                 *
 *                                                                                                           *
@@ -32,6 +34,15 @@
 *    ini value                                                                                              *
 *        A value in an ini section, it exists out of a name and a value                                     *
 *        This is represented by the dini::iniValue class (ini inivalue.h)                                   *
+*    ini snapshot                                                                                           *
+*        A read-only copy of an ini file, which can be shared between processes through a file              *
+*        This is represented by the dini::iniSnapshot class (in inisnapshot.h)                              *
+*    concurrent ini file                                                                                    *
+*        An ini file which can be changed by many threads at once, with a lock per group of sections        *
+*        This is represented by the dini::iniConcurrentFile class (in iniconcurrentfile.h)                  *
+*    ini writer                                                                                             *
+*        Writes an ini file section by section and value by value, without keeping the file in memory       *
+*        This is represented by the dini::iniWriter class (in iniwriter.h)                                  *
 ************************************************************************************************************/
 
 /********************************************* File structure: **********************************************
@@ -63,5 +74,8 @@
 ************************************************************************************************************/
 
 #include "inifile.h"
+#include "inisnapshot.h"
+#include "iniconcurrentfile.h"
+#include "iniwriter.h"
 
 #endif // DINI_H
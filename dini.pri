@@ -0,0 +1,36 @@
+# The library itself, which is shared by the example (dini.pro), the tests (tests/tests.pro) and the benchmarks (bench/bench.pro)
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/inifile.cpp \
+    $$PWD/inivalue.cpp \
+    $$PWD/dini_private.cpp \
+    $$PWD/inisection.cpp \
+    $$PWD/namerange.cpp \
+    $$PWD/dini_io.cpp \
+    $$PWD/inisnapshot.cpp \
+    $$PWD/inibatch.cpp \
+    $$PWD/iniconcurrentfile.cpp \
+    $$PWD/iniwriter.cpp \
+    $$PWD/inistats.cpp \
+    $$PWD/iniaccess.cpp
+
+HEADERS += \
+    $$PWD/inifile.h \
+    $$PWD/inivalue.h \
+    $$PWD/dini_private.h \
+    $$PWD/inisection.h \
+    $$PWD/dini.h \
+    $$PWD/namerange.h \
+    $$PWD/dini_io.h \
+    $$PWD/inisnapshot.h \
+    $$PWD/inikey.h \
+    $$PWD/inibatch.h \
+    $$PWD/iniconcurrentfile.h \
+    $$PWD/iniwriter.h \
+    $$PWD/inistats.h \
+    $$PWD/iniaccess.h
+
+# Uncomment to use io_uring for loading and saving files on Linux (falls back to read() and write() when it's not available)
+#DEFINES += DINI_USE_IO_URING
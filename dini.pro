@@ -9,21 +9,18 @@ QT       += core
 QT       -= gui
 
 TARGET = dini
-CONFIG   += console
+CONFIG   += console c++11
 CONFIG   -= app_bundle
 
 TEMPLATE = app
 
 
-SOURCES += example.cpp \
-    inifile.cpp \
-    inivalue.cpp \
-    dini_private.cpp \
-    inisection.cpp
+SOURCES += example.cpp
 
-HEADERS += \
-    inifile.h \
-    inivalue.h \
-    dini_private.h \
-    inisection.h \
-    dini.h
+include(dini.pri)
+
+# "make test" builds and runs the tests (see tests/tests.pro), and "make benchmark" the benchmarks (see bench/bench.pro),
+# each in a directory of their own next to this project
+test.commands = $(MKDIR) $$OUT_PWD/tests && cd $$OUT_PWD/tests && $$QMAKE_QMAKE $$PWD/tests/tests.pro && $(MAKE) && ./tests
+benchmark.commands = $(MKDIR) $$OUT_PWD/bench && cd $$OUT_PWD/bench && $$QMAKE_QMAKE $$PWD/bench/bench.pro && $(MAKE) && ./bench
+QMAKE_EXTRA_TARGETS += test benchmark
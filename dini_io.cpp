@@ -0,0 +1,551 @@
+#include "dini_io.h"
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define DINI_POSIX_IO
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <climits>
+    #include <cstdlib>
+#else
+    #include <fstream>
+#endif
+
+#if defined(DINI_USE_IO_URING) && defined(__linux__)
+    #define DINI_IO_URING
+    #include <linux/io_uring.h>
+    #include <sys/syscall.h>
+    #include <sys/mman.h>
+#endif
+
+namespace diniPrivate
+{
+    const size_t ioChunkSize=1<<20;         // Number of bytes per read or write call
+    const unsigned int ioQueueDepth=8;      // Maximum number of reads or writes in flight at once when using io_uring
+
+#ifdef DINI_POSIX_IO
+    // Read everything from fd into out, sizeHint is the expected size of the file, returns false on an error
+    bool readAll(const int& fd, const size_t& sizeHint, std::string& out)
+    {
+        // Leave some room after the expected size, so the end of the file is found without growing the buffer
+        size_t used=0;
+        out.resize(std::max(sizeHint+4096, ioChunkSize));
+        for(;;)
+        {
+            if(used==out.size())
+                out.resize(out.size()*2);
+            const ssize_t done=::read(fd, &out[used], out.size()-used);
+            if(done<0 && errno==EINTR)
+                continue;
+            if(done<0)
+                return false;
+            if(done==0)
+                break;
+            used+=done;
+        }
+        out.resize(used);
+        return true;
+    }
+
+    // Write all of data to fd at the given offset, returns false on an error
+    bool writeAll(const int& fd, const char* data, size_t length, off_t offset)
+    {
+        while(length!=0)
+        {
+            const ssize_t done=::pwrite(fd, data, length, offset);
+            if(done<0 && errno==EINTR)
+                continue;
+            if(done<=0)
+                return false;
+            data+=done;
+            length-=done;
+            offset+=done;
+        }
+        return true;
+    }
+#endif
+
+#ifdef DINI_IO_URING
+    // A minimal io_uring, using the system calls directly (so liburing isn't needed)
+    class uring
+    {
+        public:
+            uring()
+                :fd(-1), sqRing(MAP_FAILED), cqRing(MAP_FAILED), sqes(static_cast<io_uring_sqe*>(MAP_FAILED)), sqRingSize(0), cqRingSize(0), sqesSize(0){}
+            ~uring()
+            {
+                if(sqes!=MAP_FAILED)
+                    munmap(sqes, sqesSize);
+                if(cqRing!=MAP_FAILED && cqRing!=sqRing)
+                    munmap(cqRing, cqRingSize);
+                if(sqRing!=MAP_FAILED)
+                    munmap(sqRing, sqRingSize);
+                if(fd>=0)
+                    ::close(fd);
+            }
+
+            // Set up the ring, returns false if io_uring isn't available (in which case the caller should fall back to plain system calls)
+            bool init(const unsigned int& entries)
+            {
+                io_uring_params params;
+                std::memset(&params, 0, sizeof(params));
+                fd=syscall(__NR_io_uring_setup, entries, &params);
+                if(fd<0)
+                    return false;
+
+                // Map the submission and completion rings, and the array of submission entries
+                sqRingSize=params.sq_off.array+params.sq_entries*sizeof(unsigned int);
+                cqRingSize=params.cq_off.cqes+params.cq_entries*sizeof(io_uring_cqe);
+                if(params.features & IORING_FEAT_SINGLE_MMAP)
+                    sqRingSize=cqRingSize=std::max(sqRingSize, cqRingSize);
+                sqRing=mmap(0, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+                if(sqRing==MAP_FAILED)
+                    return false;
+                if(params.features & IORING_FEAT_SINGLE_MMAP)
+                    cqRing=sqRing;
+                else
+                {
+                    cqRing=mmap(0, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+                    if(cqRing==MAP_FAILED)
+                        return false;
+                }
+                sqesSize=params.sq_entries*sizeof(io_uring_sqe);
+                sqes=static_cast<io_uring_sqe*>(mmap(0, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+                if(sqes==MAP_FAILED)
+                    return false;
+
+                char* sq=static_cast<char*>(sqRing);
+                char* cq=static_cast<char*>(cqRing);
+                sqTail=reinterpret_cast<unsigned int*>(sq+params.sq_off.tail);
+                sqMask=reinterpret_cast<unsigned int*>(sq+params.sq_off.ring_mask);
+                sqArray=reinterpret_cast<unsigned int*>(sq+params.sq_off.array);
+                cqHead=reinterpret_cast<unsigned int*>(cq+params.cq_off.head);
+                cqTail=reinterpret_cast<unsigned int*>(cq+params.cq_off.tail);
+                cqMask=reinterpret_cast<unsigned int*>(cq+params.cq_off.ring_mask);
+                cqes=reinterpret_cast<io_uring_cqe*>(cq+params.cq_off.cqes);
+                return true;
+            }
+
+            // Queue a read or write of length bytes at offset, and submit it right away
+            // Returns false if it couldn't be submitted, the request is taken out of the queue again then (so it's never started later on)
+            bool submit(const unsigned char& opcode, const int& file, char* data, const size_t& length, const off_t& offset, const unsigned long long& userData)
+            {
+                const unsigned int tail=*sqTail;
+                const unsigned int index=tail & *sqMask;
+                io_uring_sqe& sqe=sqes[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode=opcode;
+                sqe.fd=file;
+                sqe.addr=reinterpret_cast<unsigned long long>(data);
+                sqe.len=static_cast<unsigned int>(length);
+                sqe.off=offset;
+                sqe.user_data=userData;
+                sqArray[index]=index;
+                __atomic_store_n(sqTail, tail+1, __ATOMIC_RELEASE);
+                for(;;)
+                {
+                    const int done=syscall(__NR_io_uring_enter, fd, 1, 0, 0, 0, 0);
+                    if(done==1)
+                        return true;
+                    if(done==0 || (errno!=EINTR && errno!=EAGAIN))
+                        break;
+                }
+                // The kernel didn't take the request
+                __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+                return false;
+            }
+
+            // Wait for the next completion, returns false if waiting failed
+            bool wait(unsigned long long& userData, int& result)
+            {
+                for(;;)
+                {
+                    const unsigned int head=*cqHead;
+                    if(head!=__atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+                    {
+                        const io_uring_cqe& cqe=cqes[head & *cqMask];
+                        userData=cqe.user_data;
+                        result=cqe.res;
+                        __atomic_store_n(cqHead, head+1, __ATOMIC_RELEASE);
+                        return true;
+                    }
+                    if(syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, 0, 0)<0 && errno!=EINTR)
+                        return false;
+                }
+            }
+
+        private:
+            int fd;
+            void* sqRing;
+            void* cqRing;
+            io_uring_sqe* sqes;
+            size_t sqRingSize;
+            size_t cqRingSize;
+            size_t sqesSize;
+            unsigned int* sqTail;
+            unsigned int* sqMask;
+            unsigned int* sqArray;
+            unsigned int* cqHead;
+            unsigned int* cqTail;
+            unsigned int* cqMask;
+            io_uring_cqe* cqes;
+    };
+
+    // Wait until none of the reads of uringReadAll() are in flight anymore, so the kernel never writes into out after it's returned
+    // If even waiting fails the reads can't be followed anymore, so the memory of out is handed over to a string that's never freed
+    // (out has an allocation of its own, see uringReadAll(), so swapping hands over the memory the reads write into)
+    ioResult uringAbandon(uring& ring, unsigned int& inFlight, std::string& out)
+    {
+        for(; inFlight!=0; inFlight--)
+        {
+            unsigned long long slot=0;
+            int result=0;
+            if(!ring.wait(slot, result))
+            {
+                std::string* kept=new std::string;
+                kept->swap(out);
+                break;
+            }
+        }
+        return ioError;
+    }
+
+    // Read size bytes from fd into out, with several chunks in flight at once
+    // Returns ioOpenError if io_uring isn't available (so the caller can fall back), and ioError if reading fails
+    ioResult uringReadAll(const int& fd, const size_t& size, std::string& out)
+    {
+        uring ring;
+        if(!ring.init(ioQueueDepth))
+            return ioOpenError;
+        // Make sure the data is in an allocation of its own (and not inside out itself, which short strings are), see uringAbandon()
+        out.reserve(std::max(size, sizeof(std::string)*2));
+
+        // Keep track of which part of the file each request in flight is reading
+        std::vector<size_t> slotOffset(ioQueueDepth), slotLength(ioQueueDepth);
+        std::vector<unsigned int> freeSlots;
+        for(unsigned int i=0; i<ioQueueDepth; i++)
+            freeSlots.push_back(i);
+        out.resize(size);
+        size_t next=0, end=size;
+        unsigned int inFlight=0;
+        while(next<end || inFlight!=0)
+        {
+            // Fill the queue with reads of the next chunks
+            while(next<end && !freeSlots.empty())
+            {
+                const unsigned int slot=freeSlots.back();
+                freeSlots.pop_back();
+                slotOffset[slot]=next;
+                slotLength[slot]=std::min(ioChunkSize, end-next);
+                if(!ring.submit(IORING_OP_READ, fd, &out[next], slotLength[slot], next, slot))
+                    return uringAbandon(ring, inFlight, out);
+                next+=slotLength[slot];
+                inFlight++;
+            }
+            // Handle one completed read
+            unsigned long long slot=0;
+            int result=0;
+            if(!ring.wait(slot, result))
+                return uringAbandon(ring, inFlight, out);
+            inFlight--;
+            if(result<0 && result!=-EINTR && result!=-EAGAIN)
+                return uringAbandon(ring, inFlight, out);
+            if(result==0)
+            {
+                // The file got shorter since we've asked for its size, so stop there
+                end=std::min(end, slotOffset[slot]);
+                next=std::min(next, end);
+            }
+            if(result>0)
+            {
+                slotOffset[slot]+=result;
+                slotLength[slot]-=result;
+            }
+            if(result!=0 && slotLength[slot]!=0 && slotOffset[slot]<end)
+            {
+                // An interrupted or short read, ask for the rest of the chunk
+                if(!ring.submit(IORING_OP_READ, fd, &out[slotOffset[slot]], slotLength[slot], slotOffset[slot], slot))
+                    return uringAbandon(ring, inFlight, out);
+                inFlight++;
+            }
+            else
+                freeSlots.push_back(static_cast<unsigned int>(slot));
+        }
+        out.resize(end);
+        return ioOk;
+    }
+#endif
+
+    ioResult readWholeFile(const std::string& filename, std::string& out)
+    {
+        out.clear();
+#ifdef DINI_POSIX_IO
+        const int fd=::open(filename.c_str(), O_RDONLY);
+        if(fd<0)
+            return ioOpenError;
+        // Ask for the size, so the whole file can be read into one buffer, and tell the kernel we'll read it sequentially
+        size_t size=0;
+        struct stat info;
+        if(fstat(fd, &info)==0 && S_ISREG(info.st_mode))
+            size=info.st_size;
+    #ifdef POSIX_FADV_SEQUENTIAL
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    #endif
+        ioResult result=ioOpenError;
+    #ifdef DINI_IO_URING
+        if(size!=0)
+            result=uringReadAll(fd, size, out);
+    #endif
+        // Without io_uring (or if it's not available), just use read()
+        if(result==ioOpenError)
+            result=readAll(fd, size, out) ? ioOk : ioError;
+        ::close(fd);
+        return result;
+#else
+        std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+        if(!file.good())
+            return ioOpenError;
+        file.seekg(0, std::ios_base::end);
+        out.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0, std::ios_base::beg);
+        if(!out.empty())
+            file.read(&out[0], out.size());
+        return file.good() ? ioOk : ioError;
+#endif
+    }
+
+    ioResult fileInfo(const std::string& filename, unsigned long long& modified, unsigned long long& size)
+    {
+#ifdef DINI_POSIX_IO
+        struct stat info;
+        if(::stat(filename.c_str(), &info)!=0)
+            return ioOpenError;
+    #ifdef __linux__
+        modified=static_cast<unsigned long long>(info.st_mtim.tv_sec)*1000000000ull+info.st_mtim.tv_nsec;
+    #else
+        modified=static_cast<unsigned long long>(info.st_mtime);
+    #endif
+        size=info.st_size;
+        return ioOk;
+#else
+        std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
+        if(!file.good())
+            return ioOpenError;
+        file.seekg(0, std::ios_base::end);
+        modified=0;
+        size=static_cast<unsigned long long>(file.tellg());
+        return ioOk;
+#endif
+    }
+
+    std::string canonicalPath(const std::string& filename)
+    {
+#ifdef DINI_POSIX_IO
+        char path[PATH_MAX];
+        if(::realpath(filename.c_str(), path)!=0)
+            return path;
+#endif
+        return filename;
+    }
+
+// fileWriter
+    class fileWriter::backend
+    {
+        public:
+            backend()
+                :current(0), used(0), failed(false)
+            {
+#ifdef DINI_POSIX_IO
+                fd=-1;
+                offset=0;
+#endif
+#ifdef DINI_IO_URING
+                useRing=false;
+#endif
+            }
+
+            // The buffers data is gathered in, only one is used unless io_uring is used
+            std::vector<std::vector<char> > buffers;
+            size_t current;
+            size_t used;
+            bool failed;
+#ifdef DINI_POSIX_IO
+            int fd;
+            off_t offset;
+#else
+            std::ofstream file;
+#endif
+#ifdef DINI_IO_URING
+            // Write a buffer in the background, or directly when it can't be submitted (the buffer is only busy when it's submitted)
+            bool submit(const size_t& buffer, const size_t& length)
+            {
+                if(!ring.submit(IORING_OP_WRITE, fd, &buffers[buffer][0], length, offset, buffer))
+                    return writeAll(fd, &buffers[buffer][0], length, offset);
+                bufferOffset[buffer]=offset;
+                bufferLength[buffer]=length;
+                busy[buffer]=true;
+                inFlight++;
+                return true;
+            }
+            // Wait until a write is done, and check if it was written completely
+            // If waiting itself fails, none of the writes in flight can be followed anymore, so they're all given up on
+            bool reap()
+            {
+                unsigned long long buffer=0;
+                int result=0;
+                if(!ring.wait(buffer, result))
+                {
+                    inFlight=0;
+                    return false;
+                }
+                inFlight--;
+                busy[buffer]=false;
+                if(result<0)
+                    return false;
+                // Write anything that wasn't written by the background write directly
+                if(static_cast<size_t>(result)<bufferLength[buffer])
+                    return writeAll(fd, &buffers[buffer][result], bufferLength[buffer]-result, bufferOffset[buffer]+result);
+                return true;
+            }
+
+            uring ring;
+            bool useRing;
+            std::vector<bool> busy;
+            std::vector<off_t> bufferOffset;
+            std::vector<size_t> bufferLength;
+            unsigned int inFlight;
+#endif
+    };
+
+    fileWriter::fileWriter()
+        :impl(new backend){}
+    fileWriter::~fileWriter()
+    {
+        close();
+        delete impl;
+    }
+
+    ioResult fileWriter::open(const std::string& filename)
+    {
+#ifdef DINI_POSIX_IO
+        impl->fd=::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+        if(impl->fd<0)
+            return ioOpenError;
+#else
+        impl->file.open(filename.c_str(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+        if(!impl->file.good())
+            return ioOpenError;
+#endif
+        // Use a couple of buffers with io_uring (so one can be filled while the others are written), or else just one
+        size_t bufferCount=1;
+#ifdef DINI_IO_URING
+        if(impl->ring.init(ioQueueDepth))
+        {
+            impl->useRing=true;
+            impl->inFlight=0;
+            bufferCount=4;
+            impl->busy.assign(bufferCount, false);
+            impl->bufferOffset.assign(bufferCount, 0);
+            impl->bufferLength.assign(bufferCount, 0);
+        }
+#endif
+        impl->buffers.assign(bufferCount, std::vector<char>(ioChunkSize));
+        impl->current=0;
+        impl->used=0;
+        impl->failed=false;
+        return ioOk;
+    }
+
+    ioResult fileWriter::write(const char* data, const size_t& length)
+    {
+        // Copy the data into the buffer, and write the buffer to the file each time it's full
+        size_t left=length;
+        while(left!=0 && !impl->failed)
+        {
+            const size_t part=std::min(left, ioChunkSize-impl->used);
+            std::memcpy(&impl->buffers[impl->current][impl->used], data, part);
+            impl->used+=part;
+            data+=part;
+            left-=part;
+            if(impl->used==ioChunkSize)
+                flush();
+        }
+        return impl->failed ? ioError : ioOk;
+    }
+    ioResult fileWriter::write(const std::string& data)
+    { return write(data.data(), data.length()); }
+
+    ioResult fileWriter::close()
+    {
+#ifdef DINI_POSIX_IO
+        if(impl->fd<0)
+            return impl->failed ? ioError : ioOk;
+        if(impl->used!=0)
+            flush();
+    #ifdef DINI_IO_URING
+        // Wait for all background writes to finish
+        while(impl->useRing && impl->inFlight!=0)
+        {
+            if(!impl->reap())
+                impl->failed=true;
+        }
+    #endif
+        if(::close(impl->fd)!=0)
+            impl->failed=true;
+        impl->fd=-1;
+#else
+        if(!impl->file.is_open())
+            return impl->failed ? ioError : ioOk;
+        if(impl->used!=0)
+            flush();
+        impl->file.close();
+        if(impl->file.fail())
+            impl->failed=true;
+#endif
+        return impl->failed ? ioError : ioOk;
+    }
+
+    ioResult fileWriter::flush()
+    {
+#ifdef DINI_IO_URING
+        if(impl->useRing)
+        {
+            // Start writing the current buffer in the background, and continue with a buffer which isn't being written
+            if(!impl->submit(impl->current, impl->used))
+                impl->failed=true;
+            impl->offset+=impl->used;
+            impl->used=0;
+            while(!impl->failed)
+            {
+                for(size_t i=0; i<impl->buffers.size(); i++)
+                {
+                    if(!impl->busy[i])
+                    {
+                        impl->current=i;
+                        return ioOk;
+                    }
+                }
+                if(!impl->reap())
+                    impl->failed=true;
+            }
+            return ioError;
+        }
+#endif
+#ifdef DINI_POSIX_IO
+        if(!writeAll(impl->fd, &impl->buffers[impl->current][0], impl->used, impl->offset))
+            impl->failed=true;
+        impl->offset+=impl->used;
+#else
+        impl->file.write(&impl->buffers[impl->current][0], impl->used);
+        if(!impl->file.good())
+            impl->failed=true;
+#endif
+        impl->used=0;
+        return impl->failed ? ioError : ioOk;
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef DINI_IO_H
+#define DINI_IO_H
+
+#include <string>
+#include <cstddef>
+
+namespace diniPrivate
+{
+    // Result of the file functions below
+    enum ioResult
+    {
+        ioOk,               // Everything went fine
+        ioOpenError,        // The file couldn't be opened
+        ioError             // The file was opened, but reading or writing failed
+    };
+
+    // Read a whole file into out at once
+    // On Linux this uses io_uring when compiled with DINI_USE_IO_URING (and when the kernel supports it),
+    // on other POSIX systems plain read() calls, and on anything else a std::ifstream
+    ioResult readWholeFile(const std::string& filename, std::string& out);
+
+    // Get the time the file was last changed and its size, which are used to check whether a file has changed since it was read
+    // The time is in nanoseconds on Linux and in seconds on other POSIX systems, elsewhere only the size is available (and modified is 0)
+    ioResult fileInfo(const std::string& filename, unsigned long long& modified, unsigned long long& size);
+    // Get the absolute path of an existing file, without symbolic links and . or .. parts, so the same file always gets the same path
+    // Where that isn't supported (or the file doesn't exist) the filename is returned as it is
+    std::string canonicalPath(const std::string& filename);
+
+    // Writes a file through a large buffer, which is written to the file each time it's full
+    // With io_uring the writes are done in the background, while the next buffer is being filled
+    class fileWriter
+    {
+        public:
+            fileWriter();
+            ~fileWriter();
+
+            // Open (and truncate) the file for writing
+            ioResult open(const std::string& filename);
+            // Append data to the file
+            ioResult write(const char* data, const size_t& length);
+            ioResult write(const std::string& data);
+            // Write whatever is left in the buffer and close the file
+            ioResult close();
+
+        private:
+            // Not copyable
+            fileWriter(const fileWriter&);
+            fileWriter& operator=(const fileWriter&);
+
+            // Write the current buffer to the file, and get an empty buffer to continue with
+            ioResult flush();
+
+            class backend;
+            backend* impl;
+    };
+}
+
+#endif // DINI_IO_H
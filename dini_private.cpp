@@ -1,6 +1,11 @@
 #include "dini_private.h"
+#include "dini_io.h"
 
 #include <cctype>
+#include <climits>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
 
 namespace diniPrivate
 {
@@ -22,9 +27,310 @@ namespace diniPrivate
             return false;
         for(unsigned int i=0; i<str1.length(); i++)
         {
-            if(std::tolower(str1[i])!=std::tolower(str2[i]))
+            if(std::tolower(static_cast<unsigned char>(str1[i]))!=std::tolower(static_cast<unsigned char>(str2[i])))
                 return false;
         }
         return true;
     }
+
+    bool strCaseCompare(const char* str1, const size_t& length, const char* str2)
+    {
+        for(size_t i=0; i<length; i++)
+        {
+            if(str2[i]=='\0' || std::tolower(static_cast<unsigned char>(str1[i]))!=std::tolower(static_cast<unsigned char>(str2[i])))
+                return false;
+        }
+        return str2[length]=='\0';
+    }
+
+    unsigned int hashName(const char* name, const size_t& length)
+    {
+        unsigned int hash=2166136261u;
+        for(size_t i=0; i<length; i++)
+            hash=(hash^static_cast<unsigned char>(foldCase(name[i])))*16777619u;
+        return hash;
+    }
+
+    unsigned long long hashData(const char* data, const size_t& length, const unsigned long long& seed)
+    {
+        unsigned long long hash=seed;
+        for(size_t i=0; i<length; i++)
+            hash=(hash^static_cast<unsigned char>(data[i]))*1099511628211ull;
+        return hash;
+    }
+
+    unsigned long long hashEntry(const unsigned long long& hash, const char* name, const size_t& nameLength, const char* value, const size_t& valueLength)
+    {
+        const unsigned long long lengths[2]={nameLength, valueLength};
+        unsigned long long result=hashData(reinterpret_cast<const char*>(lengths), sizeof(lengths), hash);
+        result=hashData(name, nameLength, result);
+        return hashData(value, valueLength, result);
+    }
+
+    unsigned long long hashValue(const char* name, const size_t& nameLength, const char* value, const size_t& valueLength)
+    {
+        // FNV-1a doesn't spread its bits far enough for a sum, so the hash gets the finalizer of splitmix64
+        unsigned long long hash=hashEntry(hashData(0, 0), name, nameLength, value, valueLength);
+        hash=(hash^(hash>>30))*0xbf58476d1ce4e5b9ull;
+        hash=(hash^(hash>>27))*0x94d049bb133111ebull;
+        return hash^(hash>>31);
+    }
+
+    int compareNames(const char* str1, const size_t& length1, const char* str2, const size_t& length2, const bool& caseSensitive)
+    {
+        const size_t length=std::min(length1, length2);
+        if(caseSensitive)
+        {
+            const int result=std::memcmp(str1, str2, length);
+            if(result!=0)
+                return result;
+        }
+        else
+        {
+            for(size_t i=0; i<length; i++)
+            {
+                const unsigned char c1=foldCase(str1[i]), c2=foldCase(str2[i]);
+                if(c1!=c2)
+                    return c1<c2 ? -1 : 1;
+            }
+        }
+        return length1<length2 ? -1 : (length1>length2 ? 1 : 0);
+    }
+
+    bool sameName(const char* str1, const size_t& length1, const char* str2, const size_t& length2, const bool& caseSensitive)
+    {
+        if(length1!=length2)
+            return false;
+        if(caseSensitive)
+            return std::memcmp(str1, str2, length1)==0;
+        for(size_t i=0; i<length1; i++)
+        {
+            if(foldCase(str1[i])!=foldCase(str2[i]))
+                return false;
+        }
+        return true;
+    }
+
+    std::string globPrefix(const std::string& pattern)
+    { return pattern.substr(0, pattern.find_first_of("*?")); }
+
+    void indexErase(std::vector<size_t>& index, const size_t& first, const size_t& last)
+    {
+        // Remove the erased positions and shift everything after them in one pass
+        std::vector<size_t>::iterator out=index.begin();
+        for(std::vector<size_t>::iterator pos=index.begin(); pos!=index.end(); ++pos)
+        {
+            if(*pos<first)
+                *out++=*pos;
+            else if(*pos>=last)
+                *out++=*pos-(last-first);
+        }
+        index.erase(out, index.end());
+    }
+
+    void indexCompact(std::vector<size_t>& index, const std::vector<bool>& erased)
+    {
+        // Find the new position of every item, and then remove the erased positions and renumber the others in one pass
+        std::vector<size_t> newPositions(erased.size());
+        for(size_t pos=0, kept=0; pos<erased.size(); pos++)
+        {
+            newPositions[pos]=kept;
+            if(!erased[pos])
+                kept++;
+        }
+        std::vector<size_t>::iterator out=index.begin();
+        for(std::vector<size_t>::iterator pos=index.begin(); pos!=index.end(); ++pos)
+        {
+            if(!erased[*pos])
+                *out++=newPositions[*pos];
+        }
+        index.erase(out, index.end());
+    }
+
+    size_t filterWords(const size_t& count)
+    {
+        // 16 bits for each name, rounded up to a power of two
+        size_t words=1;
+        while(words*4<count)
+            words*=2;
+        return count==0 ? 0 : words;
+    }
+
+    void filterRebuild(std::vector<unsigned long long>& filter, const std::vector<unsigned int>& hashes)
+    {
+        filter.assign(filterWords(hashes.size()), 0);
+        for(std::vector<unsigned int>::const_iterator pos=hashes.begin(); pos!=hashes.end(); ++pos)
+            filterInsert(&filter[0], filter.size(), *pos);
+    }
+
+    void filterAdded(std::vector<unsigned long long>& filter, const std::vector<unsigned int>& hashes)
+    {
+        if(filter.size()<filterWords(hashes.size()))
+            filterRebuild(filter, hashes);
+        else
+            filterInsert(&filter[0], filter.size(), hashes.back());
+    }
+
+    void filterRenamed(std::vector<unsigned long long>& filter, const std::vector<unsigned int>& hashes, const size_t& pos)
+    { filterInsert(&filter[0], filter.size(), hashes[pos]); }
+
+    bool includeFromLine(const std::string& line, std::string& path)
+    {
+        const std::string directive="@include";
+        if(line.compare(0, directive.length(), directive)!=0 || line.length()<=directive.length() || !std::isspace(static_cast<unsigned char>(line[directive.length()])))
+            return false;
+        const size_t first=line.find_first_not_of(" \t\r", directive.length());
+        if(first==std::string::npos)
+            return false;
+        path=line.substr(first, line.find_last_not_of(" \t\r")+1-first);
+        return true;
+    }
+
+    std::string includePath(const std::string& includingFile, const std::string& path)
+    {
+        const bool absolute=path[0]=='/' || path[0]=='\\' || (path.length()>1 && path[1]==':');
+        const size_t slash=includingFile.find_last_of("/\\");
+        if(absolute || slash==std::string::npos)
+            return canonicalPath(path);
+        return canonicalPath(includingFile.substr(0, slash+1)+path);
+    }
+
+    bool parseInt(const char* first, const char* last, int& out)
+    {
+        // Strip the whitespaces around the number
+        while(first!=last && std::isspace(static_cast<unsigned char>(*first)))
+            first++;
+        while(last!=first && std::isspace(static_cast<unsigned char>(*(last-1))))
+            last--;
+        if(first==last)
+            return false;
+
+        // Read the sign, and then the digits, the number is accumulated as a negative number so INT_MIN fits as well
+        const bool negative=(*first=='-');
+        if(*first=='-' || *first=='+')
+            first++;
+        if(first==last)
+            return false;
+        int number=0;
+        for(; first!=last; first++)
+        {
+            if(*first<'0' || *first>'9')
+                return false;
+            const int digit=*first-'0';
+            if(number<(INT_MIN+digit)/10)
+                return false;
+            number=number*10-digit;
+        }
+        if(!negative && number==INT_MIN)
+            return false;
+        out=negative?number:-number;
+        return true;
+    }
+
+    bool parseDouble(const char* first, const char* last, double& out)
+    {
+        // Powers of ten which can be represented exactly by a double
+        static const double exactPowers[]={1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                           1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+        // Strip the whitespaces around the number
+        while(first!=last && std::isspace(static_cast<unsigned char>(*first)))
+            first++;
+        while(last!=first && std::isspace(static_cast<unsigned char>(*(last-1))))
+            last--;
+        if(first==last)
+            return false;
+
+        // Try the fast path first: a plain decimal number with at most 15 significant digits and a small exponent
+        // Such a number can be converted exactly with just one multiplication or division, giving the same result as a stream would
+        const char* pos=first;
+        const bool negative=(*pos=='-');
+        if(*pos=='-' || *pos=='+')
+            pos++;
+        double mantissa=0;
+        int digits=0, significant=0, exponent=0;
+        bool valid=true;
+        for(; pos!=last && *pos>='0' && *pos<='9'; pos++, digits++)
+        {
+            if(mantissa!=0 || *pos!='0')
+                significant++;
+            mantissa=mantissa*10+(*pos-'0');
+        }
+        if(pos!=last && *pos=='.')
+        {
+            for(pos++; pos!=last && *pos>='0' && *pos<='9'; pos++, digits++)
+            {
+                if(mantissa!=0 || *pos!='0')
+                    significant++;
+                mantissa=mantissa*10+(*pos-'0');
+                exponent--;
+            }
+        }
+        if(digits!=0 && pos!=last && (*pos=='e' || *pos=='E'))
+        {
+            const char* expStart=++pos;
+            int expValue=0;
+            const bool expNegative=(pos!=last && *pos=='-');
+            if(pos!=last && (*pos=='-' || *pos=='+'))
+                pos++;
+            for(; pos!=last && *pos>='0' && *pos<='9' && expValue<10000; pos++)
+                expValue=expValue*10+(*pos-'0');
+            exponent+=expNegative?-expValue:expValue;
+            // If there aren't any digits in the exponent, let the stream decide
+            if(pos==expStart || (pos==expStart+1 && (*expStart=='-' || *expStart=='+')))
+                valid=false;
+        }
+        if(valid && digits!=0 && pos==last && significant<=15 && exponent>=-22 && exponent<=22)
+        {
+            double number=exponent<0 ? mantissa/exactPowers[-exponent] : mantissa*exactPowers[exponent];
+            out=negative?-number:number;
+            return true;
+        }
+
+        // Otherwise fall back to a stream, which has to consume the whole number
+        std::istringstream stream(std::string(first, last));
+        double number=0;
+        stream>>number;
+        if(stream.fail() || !stream.eof())
+            return false;
+        out=number;
+        return true;
+    }
+
+    void appendEscaped(std::string& out, const char* data, const size_t& length)
+    {
+        // Copy runs of normal characters at once, and escape the special characters in between
+        const char* runStart=data;
+        const char* end=data+length;
+        for(const char* pos=data; pos!=end; pos++)
+        {
+            char escaped;
+            switch(*pos)
+            {
+                case '\\':
+                case ';':
+                case '=':   escaped=*pos;   break;
+
+                case '\n':  escaped='n';    break;
+                case '\r':  escaped='r';    break;
+                case '\0':  escaped='0';    break;
+                default:    continue;
+            }
+            out.append(runStart, pos);
+            out+='\\';
+            out+=escaped;
+            runStart=pos+1;
+        }
+        out.append(runStart, end);
+    }
+
+    size_t stringHeapSize(const std::string& str)
+    {
+        // Short strings are stored inside the string object itself (the small string optimization), so check where the characters are
+        const char* data=str.data();
+        const char* object=reinterpret_cast<const char*>(&str);
+        if(data>=object && data<object+sizeof(std::string))
+            return 0;
+        return str.capacity()+1;
+    }
 }
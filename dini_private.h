@@ -1,12 +1,372 @@
 #ifndef DINI_PRIVATE_H
 #define DINI_PRIVATE_H
 
+#include "inivalue.h"
+
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <iterator>
+#include <chrono>
 
 namespace diniPrivate
 {
     bool validName(const std::string& str);
     bool strCaseCompare(const std::string& str1, const std::string& str2);
+    // Compares the first length characters of str1 with the null-terminated str2, ignoring case
+    bool strCaseCompare(const char* str1, const size_t& length, const char* str2);
+
+    // Convert a character to lower case, without depending on the locale (names only contain ASCII characters)
+    inline char foldCase(const char& c)
+    { return (c>='A' && c<='Z') ? static_cast<char>(c-'A'+'a') : c; }
+    // Hash a name (32 bit FNV-1a), used to quickly skip values with a different name when searching
+    // The hash ignores case, so the same hashes can be used for case sensitive and case insensitive lookups
+    unsigned int hashName(const char* name, const size_t& length);
+    // Hash any data (64 bit FNV-1a), used to check whether a value has changed without keeping a copy of it
+    // Pass the hash of the data before it as seed to hash data in parts
+    unsigned long long hashData(const char* data, const size_t& length, const unsigned long long& seed=14695981039346656037ull);
+    // Add a name and a value (or the fingerprint of a section) to a hash, including their lengths, so where one ends and the next starts matters as well
+    unsigned long long hashEntry(const unsigned long long& hash, const char* name, const size_t& nameLength, const char* value, const size_t& valueLength);
+    // Hash a name and a value on their own, with the bits mixed well enough that the hashes of many values can simply be added up
+    // A sum doesn't depend on the order, and one value can be taken out of it (or put in) without hashing the others again
+    unsigned long long hashValue(const char* name, const size_t& nameLength, const char* value, const size_t& valueLength);
+    // Compares two names the same way std::string::compare does, returns <0, 0 or >0
+    // When caseSensitive is false, the names are compared as if they were in lower case
+    int compareNames(const char* str1, const size_t& length1, const char* str2, const size_t& length2, const bool& caseSensitive=true);
+    // Checks whether two names are equal, ignoring case if caseSensitive is false
+    bool sameName(const char* str1, const size_t& length1, const char* str2, const size_t& length2, const bool& caseSensitive);
+
+    // Convert the whole of [first, last) to a number (surrounding whitespaces are allowed), returns true if succesfull
+    // These work directly on the characters, without creating a stream or string for each number
+    bool parseInt(const char* first, const char* last, int& out);
+    bool parseDouble(const char* first, const char* last, double& out);
+
+    // Append data to out, escaping the special characters the same way as they're stored in an ini file
+    void appendEscaped(std::string& out, const char* data, const size_t& length);
+    // Append a whole section (its name and all its values) to out, the same way it's stored in an ini file
+    template<class Section> void appendSection(std::string& out, const Section& section)
+    {
+        out+='[';
+        out.append(section.nameData(), section.nameLength());
+        out+="]\n";
+        for(typename Section::const_iterator pos=section.begin(); pos!=section.end(); ++pos)
+        {
+            // Write the name of the value, and then the value itself with any special characters escaped
+            out.append(pos->nameData(), pos->nameLength());
+            out+='=';
+            appendEscaped(out, pos->valueData(), pos->valueLength());
+            out+='\n';
+        }
+        out+='\n';
+    }
+
+    // Get the path of the file to include from an include directive (a line of the form "@include path", without whitespaces and comments around it)
+    // Returns false if the line isn't a valid include directive
+    bool includeFromLine(const std::string& line, std::string& path);
+    // Get the canonical path of an included file, where relative paths are relative to the directory of the including file
+    std::string includePath(const std::string& includingFile, const std::string& path);
+
+    // Returns the part of a glob pattern before the first wildcard ('*' or '?')
+    std::string globPrefix(const std::string& pattern);
+
+    // Erase the items [first, last) from a vector of iniSection or iniValue objects
+    // std::vector::erase can't be used, as it shifts the items using operator=, which only copies the value and not the name
+    template<class T> void eraseItems(std::vector<T>& items, const typename std::vector<T>::iterator& first, const typename std::vector<T>::iterator& last)
+    {
+        std::vector<T> out;
+        out.reserve(items.size()-(last-first));
+        out.insert(out.end(), items.begin(), first);
+        out.insert(out.end(), last, items.end());
+        items.swap(out);
+    }
+
+    // Converts strings to numbers the same way iniValue does, but reuses one stream for all conversions
+    // This avoids constructing (and destructing) a stream for each number when many values are converted at once
+    class numberParser
+    {
+        public:
+            template<class T> bool parse(const std::string& str, T& out)
+            {
+                stream.clear();
+                stream.str(str);
+                T tmp=T();
+                stream>>tmp;
+                if(stream.fail())
+                    return false;
+                out=tmp;
+                return true;
+            }
+
+        private:
+            std::istringstream stream;
+    };
+
+    // The fast parsers (see parseInt() and parseDouble()) by the type they give
+    inline bool parseNumber(const char* first, const char* last, int& out)
+    { return parseInt(first, last, out); }
+    inline bool parseNumber(const char* first, const char* last, double& out)
+    { return parseDouble(first, last, out); }
+    // The conversions of iniValue by the type they give
+    template<class Value> bool convertValue(const Value& value, int& out)
+    { return value.tryToInt(out); }
+    template<class Value> bool convertValue(const Value& value, double& out)
+    { return value.tryToDouble(out); }
+
+    // Convert an iniValue (which may be a null pointer), returns true if succesfull
+    // A number remembered by inferType() is used as it is, otherwise the characters of the value are parsed in place
+    // Only values the fast parsers don't accept as a whole (like "12 apples", of which a stream takes the 12) are copied into parser,
+    // so the result is always the same as that of tryToInt() or tryToDouble()
+    template<class Value, class T> bool parseValue(numberParser& parser, const Value* value, T& out)
+    {
+        if(value==0)
+            return false;
+        if(value->inferredType()==dini::typeInt || value->inferredType()==dini::typeDouble)
+            return convertValue(*value, out);
+        if(parseNumber(value->valueData(), value->valueData()+value->valueLength(), out))
+            return true;
+        return parser.parse(value->toString(), out);
+    }
+
+    // Get the value called name from each section in [first, last), converted to T, and store them in out
+    // Sections without the value, or with a value that can't be converted, get defaultValue
+    // Returns the number of values which were found and converted succesfully
+    template<class Iterator, class T> size_t extractColumn(Iterator first, Iterator last, const std::string& name, std::vector<T>& out, const T& defaultValue)
+    {
+        numberParser parser;
+        size_t found=0;
+        out.clear();
+        out.reserve(std::distance(first, last));
+        for(; first!=last; ++first)
+        {
+            T number=defaultValue;
+            if(parseValue(parser, first->tryGetValue(name), number))
+                found++;
+            out.push_back(number);
+        }
+        return found;
+    }
+
+    // Helpers to maintain a sorted index over a vector of named items (iniSection or iniValue)
+    // The index holds the positions of the items in the vector, sorted by the name of the item
+    // When caseSensitive is false the index is sorted as if all names were in lower case
+    template<class T> class nameLess
+    {
+        public:
+            nameLess(const std::vector<T>& items, const bool& caseSensitive)
+                :items(items), caseSensitive(caseSensitive){}
+            bool operator()(const size_t& lhs, const size_t& rhs) const
+            { return compareNames(items[lhs].nameData(), items[lhs].nameLength(), items[rhs].nameData(), items[rhs].nameLength(), caseSensitive)<0; }
+            bool operator()(const size_t& lhs, const std::string& rhs) const
+            { return compareNames(items[lhs].nameData(), items[lhs].nameLength(), rhs.data(), rhs.length(), caseSensitive)<0; }
+            bool operator()(const std::string& lhs, const size_t& rhs) const
+            { return compareNames(lhs.data(), lhs.length(), items[rhs].nameData(), items[rhs].nameLength(), caseSensitive)<0; }
+
+        private:
+            const std::vector<T>& items;
+            bool caseSensitive;
+    };
+
+    // Compares only the first prefix.length() characters of the names, so all names starting with prefix compare equal to it
+    template<class T> class prefixLess
+    {
+        public:
+            prefixLess(const std::vector<T>& items, const std::string& prefix, const bool& caseSensitive)
+                :items(items), prefix(prefix), caseSensitive(caseSensitive){}
+            bool operator()(const size_t& lhs, const std::string&) const
+            { return comparePrefix(items[lhs])<0; }
+            bool operator()(const std::string&, const size_t& rhs) const
+            { return comparePrefix(items[rhs])>0; }
+
+        private:
+            int comparePrefix(const T& item) const
+            { return compareNames(item.nameData(), std::min(item.nameLength(), prefix.length()), prefix.data(), prefix.length(), caseSensitive); }
+
+            const std::vector<T>& items;
+            const std::string& prefix;
+            bool caseSensitive;
+    };
+
+    // Compares names given as strings, to sort and search a list of names
+    class stringLess
+    {
+        public:
+            stringLess(const bool& caseSensitive)
+                :caseSensitive(caseSensitive){}
+            bool operator()(const std::string& lhs, const std::string& rhs) const
+            { return compareNames(lhs.data(), lhs.length(), rhs.data(), rhs.length(), caseSensitive)<0; }
+
+        private:
+            bool caseSensitive;
+    };
+
+    // Rebuild the whole index, used after bulk changes (like loading a file)
+    template<class T> void indexRebuild(std::vector<size_t>& index, const std::vector<T>& items, const bool& caseSensitive)
+    {
+        index.resize(items.size());
+        for(size_t i=0; i<index.size(); i++)
+            index[i]=i;
+        std::stable_sort(index.begin(), index.end(), nameLess<T>(items, caseSensitive));
+    }
+
+    // Add the item at position pos (which has just been added to items) to the index
+    template<class T> void indexInsert(std::vector<size_t>& index, const std::vector<T>& items, const size_t& pos, const bool& caseSensitive)
+    { index.insert(std::upper_bound(index.begin(), index.end(), pos, nameLess<T>(items, caseSensitive)), pos); }
+
+    // Remove the items at the positions [first, last) from the index, and shift the positions of the items after them
+    void indexErase(std::vector<size_t>& index, const size_t& first, const size_t& last);
+    // Remove the items marked in erased from the index, and shift the positions of the other items (keeping the index sorted)
+    void indexCompact(std::vector<size_t>& index, const std::vector<bool>& erased);
+
+    // Move the item at position pos to its new place in the index, after it has been renamed
+    template<class T> void indexRename(std::vector<size_t>& index, const std::vector<T>& items, const size_t& pos, const bool& caseSensitive)
+    {
+        index.erase(std::find(index.begin(), index.end(), pos));
+        indexInsert(index, items, pos, caseSensitive);
+    }
+
+    // Find the position (in items) of the item called name using the index, returns items.size() if there is no such item
+    template<class T> size_t indexFind(const std::vector<size_t>& index, const std::vector<T>& items, const char* name, const size_t& length, const bool& caseSensitive)
+    {
+        size_t first=0, last=index.size();
+        while(first<last)
+        {
+            const size_t middle=first+(last-first)/2;
+            const T& item=items[index[middle]];
+            if(compareNames(item.nameData(), item.nameLength(), name, length, caseSensitive)<0)
+                first=middle+1;
+            else
+                last=middle;
+        }
+        if(first!=index.size() && sameName(items[index[first]].nameData(), items[index[first]].nameLength(), name, length, caseSensitive))
+            return index[first];
+        return items.size();
+    }
+
+    // Remove the items marked in erased (and their hashes) in one pass, and make room for extra items to be added afterwards
+    // The items are copy constructed into a new vector, for the same reason as in eraseItems()
+    template<class T> void compactItems(std::vector<T>& items, std::vector<unsigned int>& hashes, const std::vector<bool>& erased, const size_t& extra)
+    {
+        std::vector<T> keptItems;
+        std::vector<unsigned int> keptHashes;
+        keptItems.reserve(items.size()+extra);
+        keptHashes.reserve(items.size()+extra);
+        for(size_t i=0; i<items.size(); i++)
+        {
+            if(!erased[i])
+            {
+                keptItems.push_back(items[i]);
+                keptHashes.push_back(hashes[i]);
+            }
+        }
+        items.swap(keptItems);
+        hashes.swap(keptHashes);
+    }
+
+    // The bytes used by the elements of a vector, and by the capacity which isn't used
+    template<class T> size_t vectorBytes(const std::vector<T>& items)
+    { return items.size()*sizeof(T); }
+    template<class T> size_t vectorSlack(const std::vector<T>& items)
+    { return (items.capacity()-items.size())*sizeof(T); }
+    // A vector of bools stores one bit per element
+    inline size_t vectorBytes(const std::vector<bool>& items)
+    { return (items.size()+7)/8; }
+    inline size_t vectorSlack(const std::vector<bool>& items)
+    { return items.capacity()/8-(items.size()+7)/8; }
+    // Release the capacity of a vector which isn't used, by copy constructing its elements into a vector of exactly the right size
+    // (shrink_to_fit() isn't binding, and doesn't copy construct the elements, see eraseItems())
+    template<class T> void shrinkVector(std::vector<T>& items)
+    {
+        if(items.capacity()!=items.size())
+            std::vector<T>(items).swap(items);
+    }
+    // The size of the allocation holding a string (including its terminating null character), which is 0 when the string is stored inside the object itself
+    size_t stringHeapSize(const std::string& str);
+
+    // Remove the elements marked in erased from a vector of plain values (which can simply be assigned), in one pass
+    template<class T> void removeMarked(std::vector<T>& items, const std::vector<bool>& erased)
+    {
+        size_t kept=0;
+        for(size_t i=0; i<items.size(); i++)
+        {
+            if(!erased[i])
+                items[kept++]=items[i];
+        }
+        items.resize(kept);
+    }
+
+    // Find the range in the index of all items whose name starts with prefix
+    template<class T> std::pair<const size_t*, const size_t*> indexPrefixRange(const std::vector<size_t>& index, const std::vector<T>& items, const std::string& prefix, const bool& caseSensitive)
+    {
+        if(index.empty())
+            return std::pair<const size_t*, const size_t*>(0, 0);
+        std::pair<std::vector<size_t>::const_iterator, std::vector<size_t>::const_iterator> range=std::equal_range(index.begin(), index.end(), prefix, prefixLess<T>(items, prefix, caseSensitive));
+        return std::pair<const size_t*, const size_t*>(&index[0]+(range.first-index.begin()), &index[0]+(range.second-index.begin()));
+    }
+
+    // Helpers to maintain a Bloom filter over the hashes of the names of the items (next to the index above)
+    // The filter tells quickly that a name isn't there, without looking at any of the items, filterMayContain() only returns true for names that may be there
+    // It's an array of 64 bit words (the number of words is a power of two), every name sets three bits in one word, so a lookup only reads one word
+    // There are about 16 bits for each name, which gives about 1% false positives
+    // A filter can't forget names, so after removing items it has to be rebuilt (when it isn't, it just gives more false positives)
+
+    // Spread the bits of a hash, so the word and the three bits of a name are taken from independent parts of it
+    inline unsigned long long filterMix(unsigned long long hash)
+    {
+        hash=(hash^(hash>>30))*0xBF58476D1CE4E5B9ULL;
+        hash=(hash^(hash>>27))*0x94D049BB133111EBULL;
+        return hash^(hash>>31);
+    }
+    inline unsigned long long filterMask(const unsigned long long& mixed)
+    { return (1ULL<<(mixed&63)) | (1ULL<<((mixed>>6)&63)) | (1ULL<<((mixed>>12)&63)); }
+
+    // Check whether a name with the given hash may be in the filter (of words words)
+    inline bool filterMayContain(const unsigned long long* filter, const size_t& words, const unsigned long long& hash)
+    {
+        if(words==0)
+            return false;
+        const unsigned long long mixed=filterMix(hash);
+        const unsigned long long mask=filterMask(mixed);
+        return (filter[(mixed>>32)&(words-1)] & mask)==mask;
+    }
+    inline bool filterMayContain(const std::vector<unsigned long long>& filter, const unsigned long long& hash)
+    { return filterMayContain(filter.empty() ? 0 : &filter[0], filter.size(), hash); }
+
+    // Add a hash to the filter (of words words, which has to be more than 0)
+    inline void filterInsert(unsigned long long* filter, const size_t& words, const unsigned long long& hash)
+    {
+        const unsigned long long mixed=filterMix(hash);
+        filter[(mixed>>32)&(words-1)]|=filterMask(mixed);
+    }
+
+    // Get the number of words a filter needs for count names
+    size_t filterWords(const size_t& count);
+    // Rebuild the whole filter from the hashes of all items, needed after items are removed
+    void filterRebuild(std::vector<unsigned long long>& filter, const std::vector<unsigned int>& hashes);
+    // Add the last hash in hashes (of the item which has just been added), the filter is rebuilt with more words when it has become too small
+    void filterAdded(std::vector<unsigned long long>& filter, const std::vector<unsigned int>& hashes);
+    // Add the hash of an item which has been renamed, its old name stays in the filter (which only gives a false positive)
+    void filterRenamed(std::vector<unsigned long long>& filter, const std::vector<unsigned int>& hashes, const size_t& pos);
+
+    // Adds the time from its construction to its destruction (in nanoseconds) to total, used to time the parts of loading and saving a file
+    // When total is a null pointer nothing is measured at all
+    class phaseTimer
+    {
+        public:
+            phaseTimer(unsigned long long* total)
+                :total(total), start(total ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()){}
+            ~phaseTimer()
+            {
+                if(total)
+                    *total+=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count();
+            }
+
+        private:
+            unsigned long long* total;
+            std::chrono::steady_clock::time_point start;
+    };
 }
 
 #endif // DINI_PRIVATE_H
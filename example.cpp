@@ -67,8 +67,14 @@ int main()
             case dini::errorCorrupted::typeNoSection:
                 cerr<<"A value was found while no section has been found yet!\n";
             break;
+            case dini::errorCorrupted::typeInclude:
+                cerr<<"Corruption found while parsing an include directive...\n";
+            break;
+            case dini::errorCorrupted::typeFilter:
+                cerr<<"The section filter failed for a section...\n";
+            break;
         }
-        cerr<<"At line: "<<e.line<<", raw data at that line:\n"<<e.lineData<<endl;
+        cerr<<"In file '"<<e.filename<<"' at line: "<<e.line<<", raw data at that line:\n"<<e.lineData<<endl;
     }
     // Catch and handle any file errors
     catch(dini::fileError& e)
@@ -0,0 +1,128 @@
+#include "iniaccess.h"
+
+namespace dini
+{
+// accessCounter
+    // Public:
+        accessCounter::accessCounter()
+            :slots(0)
+        {
+            for(size_t shard=0; shard<shardCount; shard++)
+            {
+                for(size_t segment=0; segment<segmentCount; segment++)
+                    segments[shard][segment].store(0, std::memory_order_relaxed);
+            }
+        }
+
+        accessCounter::~accessCounter()
+        {
+            for(size_t shard=0; shard<shardCount; shard++)
+            {
+                for(size_t segment=0; segment<segmentCount; segment++)
+                    delete[] segments[shard][segment].load(std::memory_order_relaxed);
+            }
+        }
+
+        size_t accessCounter::addSlot()
+        {
+            // Give out a released slot again, after setting its counters back to 0
+            std::lock_guard<std::mutex> guard(growLock);
+            if(!released.empty())
+            {
+                const size_t slot=released.back();
+                released.pop_back();
+                owners[slot]=1;
+                size_t offset=0;
+                const size_t segment=segmentOf(slot, offset);
+                for(size_t shard=0; shard<shardCount; shard++)
+                    segments[shard][segment].load(std::memory_order_relaxed)[offset].store(0, std::memory_order_relaxed);
+                return slot;
+            }
+            // Allocate the segment of the new slot in every shard if this is its first slot
+            const size_t slot=slots.load(std::memory_order_relaxed);
+            size_t offset=0;
+            const size_t segment=segmentOf(slot, offset);
+            if(offset==0)
+            {
+                for(size_t shard=0; shard<shardCount; shard++)
+                    segments[shard][segment].store(new std::atomic<unsigned long long>[static_cast<size_t>(firstSegmentSize)<<segment](), std::memory_order_release);
+            }
+            owners.push_back(1);
+            slots.store(slot+1, std::memory_order_release);
+            return slot;
+        }
+
+        void accessCounter::retain(const size_t& slot)
+        {
+            std::lock_guard<std::mutex> guard(growLock);
+            owners[slot]++;
+        }
+        void accessCounter::retain(const std::vector<size_t>& slots)
+        {
+            std::lock_guard<std::mutex> guard(growLock);
+            for(std::vector<size_t>::const_iterator slot=slots.begin(); slot!=slots.end(); ++slot)
+                owners[*slot]++;
+        }
+        void accessCounter::release(const size_t& slot)
+        {
+            std::lock_guard<std::mutex> guard(growLock);
+            if(--owners[slot]==0)
+                released.push_back(slot);
+        }
+        void accessCounter::release(const std::vector<size_t>& slots)
+        {
+            std::lock_guard<std::mutex> guard(growLock);
+            for(std::vector<size_t>::const_iterator slot=slots.begin(); slot!=slots.end(); ++slot)
+            {
+                if(--owners[*slot]==0)
+                    released.push_back(*slot);
+            }
+        }
+
+        size_t accessCounter::slotCount() const
+        { return slots.load(std::memory_order_acquire); }
+
+        void accessCounter::count(const size_t& slot)
+        {
+            // Every thread gets its own shard the first time it counts something (threads share a shard when there are more threads than shards)
+            static std::atomic<size_t> nextShard(0);
+            static thread_local const size_t shard=nextShard.fetch_add(1, std::memory_order_relaxed)%shardCount;
+            size_t offset=0;
+            const size_t segment=segmentOf(slot, offset);
+            segments[shard][segment].load(std::memory_order_acquire)[offset].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        unsigned long long accessCounter::total(const size_t& slot) const
+        {
+            size_t offset=0;
+            const size_t segment=segmentOf(slot, offset);
+            unsigned long long sum=0;
+            for(size_t shard=0; shard<shardCount; shard++)
+                sum+=segments[shard][segment].load(std::memory_order_acquire)[offset].load(std::memory_order_relaxed);
+            return sum;
+        }
+
+        void accessCounter::reset()
+        {
+            const size_t used=slots.load(std::memory_order_acquire);
+            for(size_t slot=0; slot<used; slot++)
+            {
+                size_t offset=0;
+                const size_t segment=segmentOf(slot, offset);
+                for(size_t shard=0; shard<shardCount; shard++)
+                    segments[shard][segment].load(std::memory_order_acquire)[offset].store(0, std::memory_order_relaxed);
+            }
+        }
+
+    // Private:
+        size_t accessCounter::segmentOf(const size_t& slot, size_t& offset)
+        {
+            // Find the highest bit of slot+firstSegmentSize, which is at least the bit of firstSegmentSize itself
+            const size_t shifted=slot+firstSegmentSize;
+            size_t segment=0;
+            while((shifted>>segment)>=static_cast<size_t>(firstSegmentSize)*2)
+                segment++;
+            offset=shifted-(static_cast<size_t>(firstSegmentSize)<<segment);
+            return segment;
+        }
+}
@@ -0,0 +1,79 @@
+#ifndef INIACCESS_H
+#define INIACCESS_H
+
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* This code is under the GPLv3 license.                                                                     *
+* That means that you're free to use and edit this code,                                                    *
+* as long as you publish any changes you make using this license.                                           *
+*                                                                                                           *
+* For the full license, see gpl3.txt or gpl3.html.                                                          *
+************************************************************************************************************/
+
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+
+namespace dini
+{
+    // How often a section or value was looked up, as reported by iniFile::accessCounts()
+    struct accessCount
+    {
+        std::string section;        // Name of the section
+        std::string name;           // Name of the value, or an empty string for the section itself
+        unsigned long long count;   // Number of times it was looked up
+    };
+
+    // The counters used while counting accesses (see iniFile::setAccessCounting()), shared by a file and all its sections
+    // Each section and value gets a slot, which has a counter in each of a few shards, and each thread always uses the same shard,
+    // so threads looking up the same value at the same time mostly don't write to the same cache line
+    // Counting never locks anything, and since the counters never move, new slots can be added while other threads are counting
+    // A slot can be owned by several sections (a copy of a section counts in the slots of the original), once all owners have released it,
+    // it's given out again by addSlot(), so replacing the values of a section over and over doesn't keep adding slots
+    class accessCounter
+    {
+        public:
+            accessCounter();
+            ~accessCounter();
+
+            // Get a slot with all its counters at 0 (a released one if there is one), owned by the caller
+            size_t addSlot();
+            // Add an owner to slots, or remove one (a slot without owners is given out again by addSlot())
+            void retain(const size_t& slot);
+            void retain(const std::vector<size_t>& slots);
+            void release(const size_t& slot);
+            void release(const std::vector<size_t>& slots);
+            // Get the number of slots there are (used or not), the memory used only grows with this
+            size_t slotCount() const;
+            // Count an access to a slot
+            void count(const size_t& slot);
+            // Get the number of accesses to a slot (the sum of all shards)
+            unsigned long long total(const size_t& slot) const;
+            // Set all counters back to 0
+            void reset();
+
+        private:
+            // Can't be copied
+            accessCounter(const accessCounter& other);
+            accessCounter& operator=(const accessCounter& other);
+
+            // The counters of each shard are stored in segments which double in size, so they never have to be moved when more slots are needed
+            // Segment k holds the slots s for which s+firstSegmentSize lies in [firstSegmentSize<<k, firstSegmentSize<<(k+1))
+            enum { shardCount=4, firstSegmentSize=1024, segmentCount=40 };
+            // Get the segment of a slot, and its position in that segment
+            static size_t segmentOf(const size_t& slot, size_t& offset);
+
+            std::atomic<std::atomic<unsigned long long>*> segments[shardCount][segmentCount];
+            std::mutex growLock;            // Held while adding, retaining or releasing slots
+            std::atomic<size_t> slots;      // Number of slots there are
+            std::vector<unsigned int> owners;   // Number of owners of each slot
+            std::vector<size_t> released;   // Slots without owners, which are given out again first
+    };
+}
+
+#endif // INIACCESS_H
@@ -0,0 +1,68 @@
+#include "inibatch.h"
+
+namespace dini
+{
+// iniBatch
+    // Public:
+        void iniBatch::setValue(const std::string& section, const std::string& name, const iniValue& value)
+        { addValueOperation(opSetValue, section, name, iniValue(name, value)); }
+        void iniBatch::setValue(const std::string& section, const std::string& name, const int& value)
+        { addValueOperation(opSetValue, section, name, iniValue(name, value)); }
+        void iniBatch::setValue(const std::string& section, const std::string& name, const double& value)
+        { addValueOperation(opSetValue, section, name, iniValue(name, value)); }
+        void iniBatch::setValue(const std::string& section, const std::string& name, const char& value)
+        { addValueOperation(opSetValue, section, name, iniValue(name, value)); }
+        void iniBatch::setValue(const std::string& section, const std::string& name, const bool& value)
+        { addValueOperation(opSetValue, section, name, iniValue(name, value)); }
+        void iniBatch::setValue(const std::string& section, const std::string& name, const std::string& value)
+        { addValueOperation(opSetValue, section, name, iniValue(name, value)); }
+        void iniBatch::setValue(const std::string& section, const std::string& name, const char* value)
+        { addValueOperation(opSetValue, section, name, iniValue(name, value)); }
+
+        void iniBatch::eraseValue(const std::string& section, const std::string& name)
+        { addValueOperation(opEraseValue, section, name, iniValue(name)); }
+
+        void iniBatch::setSection(const std::string& name, const iniSection& section)
+        {
+            operation op;
+            op.type=opSetSection;
+            op.section=name;
+            op.data=sections.size();
+            sections.push_back(section);
+            operations.push_back(op);
+        }
+
+        void iniBatch::eraseSection(const std::string& name)
+        {
+            operation op;
+            op.type=opEraseSection;
+            op.section=name;
+            op.data=0;
+            operations.push_back(op);
+        }
+
+        size_t iniBatch::size() const
+        { return operations.size(); }
+        bool iniBatch::empty() const
+        { return operations.empty(); }
+
+        void iniBatch::clear()
+        {
+            operations.clear();
+            values.clear();
+            sections.clear();
+        }
+
+    // Private:
+        void iniBatch::addValueOperation(const operationType& type, const std::string& section, const std::string& name, const iniValue& value)
+        {
+            // The names are only checked when the batch is applied, so the name is stored as given as well
+            operation op;
+            op.type=type;
+            op.section=section;
+            op.name=name;
+            op.data=values.size();
+            values.push_back(value);
+            operations.push_back(op);
+        }
+}
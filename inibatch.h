@@ -0,0 +1,79 @@
+#ifndef INIBATCH_H
+#define INIBATCH_H
+
+
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* This code is under the GPLv3 license.                                                                     *
+* That means that you're free to use and edit this code,                                                    *
+* as long as you publish any changes you make using this license.                                           *
+*                                                                                                           *
+* For the full license, see gpl3.txt or gpl3.html.                                                          *
+************************************************************************************************************/
+
+#include "inisection.h"
+#include <vector>
+#include <string>
+
+namespace dini
+{
+    // A list of changes to an iniFile, which are applied all at once by iniFile::apply()
+    // The changes are applied in the order they were added, but each section and value only has to be looked up once,
+    // and the sections and values are only moved around once for the whole batch (instead of for every single change)
+    class iniBatch
+    {
+        public:
+            // Set a value in a section, the section and value are created if they don't exist yet
+            void setValue(const std::string& section, const std::string& name, const iniValue& value);
+            void setValue(const std::string& section, const std::string& name, const int& value);
+            void setValue(const std::string& section, const std::string& name, const double& value);
+            void setValue(const std::string& section, const std::string& name, const char& value);
+            void setValue(const std::string& section, const std::string& name, const bool& value);
+            void setValue(const std::string& section, const std::string& name, const std::string& value);
+            void setValue(const std::string& section, const std::string& name, const char* value);
+            // Erase a value from a section (if it exists)
+            void eraseValue(const std::string& section, const std::string& name);
+            // Change the contents of an entire section, the section is created if it doesn't exist yet
+            void setSection(const std::string& name, const iniSection& section);
+            // Erase a section (if it exists)
+            void eraseSection(const std::string& name);
+
+            // Get the number of changes in this batch
+            size_t size() const;
+            // Check whether this batch is empty
+            bool empty() const;
+            // Remove all changes from this batch
+            void clear();
+
+        private:
+            friend class iniFile;
+
+            enum operationType
+            {
+                opSetValue,
+                opEraseValue,
+                opSetSection,
+                opEraseSection
+            };
+
+            struct operation
+            {
+                operationType type;
+                std::string section;    // Name of the section
+                std::string name;       // Name of the value (for opSetValue and opEraseValue)
+                size_t data;            // Position in values (for opSetValue and opEraseValue) or sections (for opSetSection)
+            };
+
+            // Add an operation on a value, which is stored in values
+            void addValueOperation(const operationType& type, const std::string& section, const std::string& name, const iniValue& value);
+
+            std::vector<operation> operations;
+            std::vector<iniValue> values;
+            std::vector<iniSection> sections;
+    };
+}
+
+#endif // INIBATCH_H
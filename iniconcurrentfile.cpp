@@ -0,0 +1,337 @@
+#include "iniconcurrentfile.h"
+#include "dini_private.h"
+#include "dini_io.h"
+
+#include <algorithm>
+
+namespace dini
+{
+// iniConcurrentFile
+    // Public:
+        iniConcurrentFile::iniConcurrentFile(const size_t& shardCount, const bool& caseSensitive)
+            :caseSensitive(caseSensitive), nextOrder(0)
+        {
+            for(size_t i=0; i<std::max(shardCount, static_cast<size_t>(1)); i++)
+                shards.push_back(std::unique_ptr<shard>(new shard));
+        }
+
+        iniConcurrentFile::iniConcurrentFile(const iniFile& file, const size_t& shardCount)
+            :caseSensitive(file.isCaseSensitive()), nextOrder(0)
+        {
+            for(size_t i=0; i<std::max(shardCount, static_cast<size_t>(1)); i++)
+                shards.push_back(std::unique_ptr<shard>(new shard));
+            appendAll(file);
+        }
+
+        bool iniConcurrentFile::isCaseSensitive() const
+        { return caseSensitive; }
+
+        iniSection iniConcurrentFile::getSection(const std::string& name) const throw(unknownName)
+        {
+            iniSection out;
+            if(!tryGetSection(name, out))
+                throw unknownName(name);
+            return out;
+        }
+
+        bool iniConcurrentFile::tryGetSection(const std::string& name, iniSection& out) const
+        {
+            const unsigned int hash=diniPrivate::hashName(name.data(), name.length());
+            shard& target=shardOf(hash);
+            std::lock_guard<std::mutex> guard(target.lock);
+            const size_t pos=findSection(target, name, hash);
+            if(pos==target.sections.size())
+                return false;
+            // Copy the name and the case sensitivity as well (operator= only copies the values)
+            out.setCaseSensitive(caseSensitive);
+            out=target.sections[pos];
+            out.setName(target.sections[pos].name());
+            return true;
+        }
+
+        void iniConcurrentFile::setSection(const std::string& name, const iniSection& section)
+        {
+            shard& target=shardOf(name);
+            std::lock_guard<std::mutex> guard(target.lock);
+            sectionIn(target, name)=section;
+        }
+
+        bool iniConcurrentFile::rename(const std::string& oldName, const std::string& newName)
+        {
+            if(!diniPrivate::validName(newName))
+                return false;
+            // Lock the shards of both names (which may be the same shard), std::lock makes sure this can't deadlock with another rename
+            const unsigned int oldHash=diniPrivate::hashName(oldName.data(), oldName.length());
+            const unsigned int newHash=diniPrivate::hashName(newName.data(), newName.length());
+            shard& from=shardOf(oldHash);
+            shard& to=shardOf(newHash);
+            std::unique_lock<std::mutex> fromGuard(from.lock, std::defer_lock);
+            std::unique_lock<std::mutex> toGuard(to.lock, std::defer_lock);
+            if(&from==&to)
+                fromGuard.lock();
+            else
+                std::lock(fromGuard, toGuard);
+
+            // If the section doesn't exist, or the new name already exists (except when only the case of the name changes), return false
+            const size_t pos=findSection(from, oldName, oldHash);
+            if(pos==from.sections.size())
+                return false;
+            const size_t existing=findSection(to, newName, newHash);
+            if(existing!=to.sections.size() && (&from!=&to || existing!=pos || diniPrivate::sameName(from.sections[pos].nameData(), from.sections[pos].nameLength(), newName.data(), newName.length(), true)))
+                return false;
+
+            // Rename it in place when it stays in the same shard, or move it (with its place in the order) to the other shard
+            if(&from==&to)
+            {
+                from.sections[pos].setName(newName);
+                from.nameHashes[pos]=newHash;
+                diniPrivate::filterRenamed(from.nameFilter, from.nameHashes, pos);
+                return true;
+            }
+            iniSection renamed(newName, from.sections[pos]);
+            appendSection(to, renamed, newHash, from.order[pos]);
+            diniPrivate::eraseItems(from.sections, from.sections.begin()+pos, from.sections.begin()+pos+1);
+            from.nameHashes.erase(from.nameHashes.begin()+pos);
+            diniPrivate::filterRebuild(from.nameFilter, from.nameHashes);
+            from.order.erase(from.order.begin()+pos);
+            return true;
+        }
+
+        bool iniConcurrentFile::erase(const std::string& name)
+        {
+            const unsigned int hash=diniPrivate::hashName(name.data(), name.length());
+            shard& target=shardOf(hash);
+            std::lock_guard<std::mutex> guard(target.lock);
+            const size_t pos=findSection(target, name, hash);
+            if(pos==target.sections.size())
+                return false;
+            diniPrivate::eraseItems(target.sections, target.sections.begin()+pos, target.sections.begin()+pos+1);
+            target.nameHashes.erase(target.nameHashes.begin()+pos);
+            diniPrivate::filterRebuild(target.nameFilter, target.nameHashes);
+            target.order.erase(target.order.begin()+pos);
+            return true;
+        }
+
+        bool iniConcurrentFile::sectionExists(const std::string& name) const
+        {
+            const unsigned int hash=diniPrivate::hashName(name.data(), name.length());
+            shard& target=shardOf(hash);
+            std::lock_guard<std::mutex> guard(target.lock);
+            return findSection(target, name, hash)!=target.sections.size();
+        }
+
+        iniValue iniConcurrentFile::getValue(const std::string& section, const std::string& name) const throw(unknownName)
+        {
+            iniValue out;
+            if(!tryGetValue(section, name, out))
+                throw unknownName(sectionExists(section) ? name : section);
+            return out;
+        }
+
+        bool iniConcurrentFile::tryGetValue(const std::string& section, const std::string& name, iniValue& out) const
+        {
+            const unsigned int hash=diniPrivate::hashName(section.data(), section.length());
+            shard& target=shardOf(hash);
+            std::lock_guard<std::mutex> guard(target.lock);
+            const size_t pos=findSection(target, section, hash);
+            const iniValue* value=pos!=target.sections.size() ? target.sections[pos].tryGetValue(name) : 0;
+            if(value==0)
+                return false;
+            // Copy the name as well (operator= only copies the value)
+            out=*value;
+            out.setName(value->name());
+            return true;
+        }
+
+        void iniConcurrentFile::setValue(const std::string& section, const std::string& name, const iniValue& value)
+        {
+            shard& target=shardOf(section);
+            std::lock_guard<std::mutex> guard(target.lock);
+            sectionIn(target, section).setValue(name, value);
+        }
+        void iniConcurrentFile::setValue(const std::string& section, const std::string& name, const int& value)
+        { setValue(section, name, iniValue(name, value)); }
+        void iniConcurrentFile::setValue(const std::string& section, const std::string& name, const double& value)
+        { setValue(section, name, iniValue(name, value)); }
+        void iniConcurrentFile::setValue(const std::string& section, const std::string& name, const char& value)
+        { setValue(section, name, iniValue(name, value)); }
+        void iniConcurrentFile::setValue(const std::string& section, const std::string& name, const bool& value)
+        { setValue(section, name, iniValue(name, value)); }
+        void iniConcurrentFile::setValue(const std::string& section, const std::string& name, const std::string& value)
+        { setValue(section, name, iniValue(name, value)); }
+        void iniConcurrentFile::setValue(const std::string& section, const std::string& name, const char* value)
+        { setValue(section, name, iniValue(name, value)); }
+
+        bool iniConcurrentFile::eraseValue(const std::string& section, const std::string& name)
+        {
+            const unsigned int hash=diniPrivate::hashName(section.data(), section.length());
+            shard& target=shardOf(hash);
+            std::lock_guard<std::mutex> guard(target.lock);
+            const size_t pos=findSection(target, section, hash);
+            return pos!=target.sections.size() && target.sections[pos].erase(name);
+        }
+
+        size_t iniConcurrentFile::size() const
+        {
+            // Lock the shards one by one, the result may already be outdated anyway when it's returned
+            size_t out=0;
+            for(std::vector<std::unique_ptr<shard> >::const_iterator pos=shards.begin(); pos!=shards.end(); ++pos)
+            {
+                std::lock_guard<std::mutex> guard((*pos)->lock);
+                out+=(*pos)->sections.size();
+            }
+            return out;
+        }
+
+        void iniConcurrentFile::clear()
+        {
+            std::vector<std::unique_lock<std::mutex> > locks=lockAll();
+            for(std::vector<std::unique_ptr<shard> >::iterator pos=shards.begin(); pos!=shards.end(); ++pos)
+            {
+                (*pos)->sections.clear();
+                (*pos)->nameHashes.clear();
+                (*pos)->nameFilter.clear();
+                (*pos)->order.clear();
+            }
+        }
+
+        iniFile iniConcurrentFile::toIniFile() const
+        {
+            // Copy the sections straight into the file, and build its index once at the end
+            iniFile out;
+            out.setCaseSensitive(caseSensitive);
+            std::vector<std::unique_lock<std::mutex> > locks=lockAll();
+            const std::vector<const iniSection*> sections=ordered();
+            out.sections.reserve(sections.size());
+            out.nameHashes.reserve(sections.size());
+            for(std::vector<const iniSection*>::const_iterator pos=sections.begin(); pos!=sections.end(); ++pos)
+            {
+                out.sections.push_back(**pos);
+                out.nameHashes.push_back(diniPrivate::hashName((*pos)->nameData(), (*pos)->nameLength()));
+            }
+            diniPrivate::filterRebuild(out.nameFilter, out.nameHashes);
+            diniPrivate::indexRebuild(out.nameIndex, out.sections, caseSensitive);
+            return out;
+        }
+
+        void iniConcurrentFile::saveToFile(const std::string& filename) const throw(fileError)
+        {
+            // Open file for writing, and check if it's openend succesfully
+            diniPrivate::fileWriter file;
+            if(file.open(filename)!=diniPrivate::ioOk)
+                throw fileError(filename, fileError::openForWritingError);
+
+            // Write the sections in the order they were added, the same way iniFile does
+            {
+                std::vector<std::unique_lock<std::mutex> > locks=lockAll();
+                const std::vector<const iniSection*> sections=ordered();
+                std::string buffer;
+                for(std::vector<const iniSection*>::const_iterator pos=sections.begin(); pos!=sections.end(); ++pos)
+                {
+                    buffer.clear();
+                    diniPrivate::appendSection(buffer, **pos);
+                    if(file.write(buffer)!=diniPrivate::ioOk)
+                        throw fileError(filename, fileError::writeError);
+                }
+            }
+            if(file.close()!=diniPrivate::ioOk)
+                throw fileError(filename, fileError::writeError);
+        }
+
+        void iniConcurrentFile::loadFromFile(const std::string& filename) throw(fileError, errorCorrupted)
+        {
+            // Parse the file without holding any lock, then replace all sections at once
+            iniFile loaded;
+            loaded.setCaseSensitive(caseSensitive);
+            loaded.loadFromFile(filename);
+
+            std::vector<std::unique_lock<std::mutex> > locks=lockAll();
+            for(std::vector<std::unique_ptr<shard> >::iterator pos=shards.begin(); pos!=shards.end(); ++pos)
+            {
+                (*pos)->sections.clear();
+                (*pos)->nameHashes.clear();
+                (*pos)->nameFilter.clear();
+                (*pos)->order.clear();
+            }
+            appendAll(loaded);
+        }
+
+    // Private:
+        iniConcurrentFile::shard& iniConcurrentFile::shardOf(const std::string& name) const
+        {
+            // A section created with an invalid name is called "section" instead (see iniSection), so it belongs to the shard of that name
+            if(!diniPrivate::validName(name))
+                return shardOf(diniPrivate::hashName("section", 7));
+            return shardOf(diniPrivate::hashName(name.data(), name.length()));
+        }
+        iniConcurrentFile::shard& iniConcurrentFile::shardOf(const unsigned int& hash) const
+        { return *shards[hash%shards.size()]; }
+
+        size_t iniConcurrentFile::findSection(const shard& target, const std::string& name, const unsigned int& hash) const
+        {
+            // Skip shards which certainly don't have the name, otherwise scan the hashes of the shard and only compare the actual name when the hash matches
+            if(!diniPrivate::filterMayContain(target.nameFilter, hash))
+                return target.sections.size();
+            for(size_t pos=0; pos<target.nameHashes.size(); pos++)
+            {
+                if(target.nameHashes[pos]==hash && diniPrivate::sameName(target.sections[pos].nameData(), target.sections[pos].nameLength(), name.data(), name.length(), caseSensitive))
+                    return pos;
+            }
+            return target.sections.size();
+        }
+
+        iniSection& iniConcurrentFile::sectionIn(shard& target, const std::string& name)
+        {
+            const size_t pos=findSection(target, name, diniPrivate::hashName(name.data(), name.length()));
+            if(pos!=target.sections.size())
+                return target.sections[pos];
+            const iniSection created(name);
+            appendSection(target, created, diniPrivate::hashName(created.nameData(), created.nameLength()), nextOrder++);
+            return target.sections.back();
+        }
+
+        void iniConcurrentFile::appendSection(shard& target, const iniSection& section, const unsigned int& hash, const unsigned long long& order)
+        {
+            target.sections.push_back(section);
+            target.sections.back().setCaseSensitive(caseSensitive);
+            target.nameHashes.push_back(hash);
+            diniPrivate::filterAdded(target.nameFilter, target.nameHashes);
+            target.order.push_back(order);
+        }
+
+        void iniConcurrentFile::appendAll(const iniFile& file)
+        {
+            // The file already has the hashes of all names, the sections marked as erased are skipped (the file is const, so it isn't compacted)
+            for(size_t pos=0; pos<file.sections.size(); pos++)
+            {
+                if(file.tombstoneCount==0 || !file.tombstones[pos])
+                    appendSection(shardOf(file.nameHashes[pos]), file.sections[pos], file.nameHashes[pos], nextOrder++);
+            }
+        }
+
+        std::vector<std::unique_lock<std::mutex> > iniConcurrentFile::lockAll() const
+        {
+            std::vector<std::unique_lock<std::mutex> > out;
+            out.reserve(shards.size());
+            for(std::vector<std::unique_ptr<shard> >::const_iterator pos=shards.begin(); pos!=shards.end(); ++pos)
+                out.push_back(std::unique_lock<std::mutex>((*pos)->lock));
+            return out;
+        }
+
+        std::vector<const iniSection*> iniConcurrentFile::ordered() const
+        {
+            // Gather the sections of all shards with their place in the order, and sort them by it
+            std::vector<std::pair<unsigned long long, const iniSection*> > all;
+            for(std::vector<std::unique_ptr<shard> >::const_iterator pos=shards.begin(); pos!=shards.end(); ++pos)
+            {
+                for(size_t i=0; i<(*pos)->sections.size(); i++)
+                    all.push_back(std::make_pair((*pos)->order[i], &(*pos)->sections[i]));
+            }
+            std::sort(all.begin(), all.end());
+            std::vector<const iniSection*> out;
+            out.reserve(all.size());
+            for(std::vector<std::pair<unsigned long long, const iniSection*> >::const_iterator pos=all.begin(); pos!=all.end(); ++pos)
+                out.push_back(pos->second);
+            return out;
+        }
+}
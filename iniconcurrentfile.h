@@ -0,0 +1,145 @@
+#ifndef INICONCURRENTFILE_H
+#define INICONCURRENTFILE_H
+
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* This code is under the GPLv3 license.                                                                     *
+* That means that you're free to use and edit this code,                                                    *
+* as long as you publish any changes you make using this license.                                           *
+*                                                                                                           *
+* For the full license, see gpl3.txt or gpl3.html.                                                          *
+************************************************************************************************************/
+
+#include "inifile.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+namespace dini
+{
+    // An ini file which can be used and changed by many threads at once
+    // The sections are spread over a number of shards (by the hash of their name), which each have their own lock,
+    // so threads working on sections in different shards don't have to wait for each other
+    // The order in which the sections were added is remembered, so the file is still saved (and iterated) in that order
+    // Since other threads can change a section at any time, sections and values are returned as copies,
+    // use update() to change a section in place, or to read and change it in one step
+    class iniConcurrentFile
+    {
+        public:
+            // Creates an empty file, with the given number of shards (at least 1)
+            // More shards means less waiting when many threads use the file at once, but saving the file has to lock all of them
+            iniConcurrentFile(const size_t& shardCount=16, const bool& caseSensitive=true);
+            // Creates a file with the same sections (and case sensitivity) as file
+            iniConcurrentFile(const iniFile& file, const size_t& shardCount=16);
+
+            // Whether the names of sections and values are case sensitive (see iniFile::setCaseSensitive()), this is fixed when the file is created
+            bool isCaseSensitive() const;
+
+            // Get a copy of a section by name
+            iniSection getSection(const std::string& name) const throw(unknownName);
+            // Get a copy of a section by name without throwing, returns false if the section doesn't exist
+            bool tryGetSection(const std::string& name, iniSection& out) const;
+            // Change the contents of an entire section, the section is created if it doesn't exist yet
+            void setSection(const std::string& name, const iniSection& section);
+            // Rename a section (the new name may not already exist), returns true if the renaming was succesfull
+            // The section keeps its place in the order of the file
+            bool rename(const std::string& oldName, const std::string& newName);
+            // Erase a section, returns true if the section was found and erased succesfull
+            bool erase(const std::string& name);
+            // Check whether a section exists
+            bool sectionExists(const std::string& name) const;
+
+            // Get a copy of a value in a section
+            iniValue getValue(const std::string& section, const std::string& name) const throw(unknownName);
+            // Get a copy of a value in a section without throwing, returns false if the section or value doesn't exist
+            bool tryGetValue(const std::string& section, const std::string& name, iniValue& out) const;
+            // Set a value in a section, the section and value are created if they don't exist yet
+            void setValue(const std::string& section, const std::string& name, const iniValue& value);
+            void setValue(const std::string& section, const std::string& name, const int& value);
+            void setValue(const std::string& section, const std::string& name, const double& value);
+            void setValue(const std::string& section, const std::string& name, const char& value);
+            void setValue(const std::string& section, const std::string& name, const bool& value);
+            void setValue(const std::string& section, const std::string& name, const std::string& value);
+            void setValue(const std::string& section, const std::string& name, const char* value);
+            // Erase a value from a section, returns true if the value was found and erased succesfull
+            bool eraseValue(const std::string& section, const std::string& name);
+
+            // Call f with the section called name (which is created if it doesn't exist yet) while holding the lock of its shard
+            // Other threads can use sections in other shards in the meantime, but f shouldn't use this file itself (that could deadlock),
+            // and it shouldn't rename the section (use rename() for that)
+            template<class Function> void update(const std::string& name, Function f)
+            {
+                shard& target=shardOf(name);
+                std::lock_guard<std::mutex> guard(target.lock);
+                f(sectionIn(target, name));
+            }
+
+            // Call f with every section (as a const iniSection&), in the order they were added
+            // All shards are locked while doing this, so f sees the file as it was at one moment, and shouldn't use this file itself
+            template<class Function> void forEach(Function f) const
+            {
+                std::vector<std::unique_lock<std::mutex> > locks=lockAll();
+                const std::vector<const iniSection*> sections=ordered();
+                for(std::vector<const iniSection*>::const_iterator pos=sections.begin(); pos!=sections.end(); ++pos)
+                    f(**pos);
+            }
+
+            // Get the number of sections
+            size_t size() const;
+            // Clear the whole file (remove all sections)
+            void clear();
+
+            // Get a copy of the whole file, as it was at one moment, with the sections in the order they were added
+            iniFile toIniFile() const;
+
+            // Save all data to a ini file, the sections are written in the order they were added
+            // All shards are locked while the file is being written
+            void saveToFile(const std::string& filename) const throw(fileError);
+            // Load all data from a ini file (see iniFile::loadFromFile()), replacing all sections at once
+            // The file is parsed before any shard is locked, so other threads only have to wait while the sections are moved in
+            void loadFromFile(const std::string& filename) throw(fileError, errorCorrupted);
+
+        private:
+            // A part of the sections, with its own lock
+            struct shard
+            {
+                std::mutex lock;
+                std::vector<iniSection> sections;
+                std::vector<unsigned int> nameHashes;       // Hashes of the names of the sections, in the same order as sections
+                std::vector<unsigned long long> nameFilter; // Bloom filter over nameHashes
+                std::vector<unsigned long long> order;      // When each section was added (a higher number is added later), in the same order as sections
+            };
+
+            // Can't be copied (use toIniFile() and the constructor taking an iniFile instead)
+            iniConcurrentFile(const iniConcurrentFile& other);
+            iniConcurrentFile& operator=(const iniConcurrentFile& other);
+
+            // Get the shard the section with the given name (or the given hash of its name) belongs to
+            shard& shardOf(const std::string& name) const;
+            shard& shardOf(const unsigned int& hash) const;
+            // Get the position of the section with the given name in a shard, returns target.sections.size() if there is no such section
+            // The lock of the shard has to be held by the caller (the same goes for the functions below)
+            size_t findSection(const shard& target, const std::string& name, const unsigned int& hash) const;
+            // Get the section with the given name in a shard, the section is created if it doesn't exist yet
+            iniSection& sectionIn(shard& target, const std::string& name);
+            // Add a section to a shard, with the given place in the order of the file
+            void appendSection(shard& target, const iniSection& section, const unsigned int& hash, const unsigned long long& order);
+            // Add all sections of file (after the ones which are already there), all shards have to be locked
+            void appendAll(const iniFile& file);
+            // Lock all shards (always in the same order, so two threads doing this can't deadlock), until the returned locks are destroyed
+            std::vector<std::unique_lock<std::mutex> > lockAll() const;
+            // Get all sections in the order they were added, all shards have to be locked
+            std::vector<const iniSection*> ordered() const;
+
+            std::vector<std::unique_ptr<shard> > shards;
+            bool caseSensitive;
+            std::atomic<unsigned long long> nextOrder;      // The place in the order of the file for the next section which is added
+    };
+}
+
+#endif // INICONCURRENTFILE_H
@@ -1,7 +1,15 @@
 #include "inifile.h"
+#include "inisnapshot.h"
 #include "dini_private.h"
+#include "dini_io.h"
 
-#include <fstream>
+#include <memory>
+#include <mutex>
+#include <map>
+#include <unordered_map>
+#include <atomic>
+#include <thread>
+#include <cstring>
 #include <cctype>
 
 namespace dini
@@ -13,223 +21,1303 @@ namespace dini
 
 // errorCorrupted
     // Public:
-        errorCorrupted::errorCorrupted(const std::string& lineData, const unsigned int& line, const corruptionType& type)
-            :lineData(lineData), line(line), type(type){}
+        errorCorrupted::errorCorrupted(const std::string& lineData, const unsigned int& line, const corruptionType& type, const std::string& filename)
+            :lineData(lineData), line(line), type(type), filename(filename){}
+
+// interpolationError
+    // Public:
+        interpolationError::interpolationError(const std::string& reference, const errorType& type)
+            :reference(reference), type(type){}
+
+// iniFile::expansionCache
+    // The cache behind iniFile::getExpanded()
+    // Every entry holds an expanded value, together with the raw values it was made from (the value itself and every value it refers to),
+    // the entry is only used when all of those values still exist and are unchanged
+    // A value counts as unchanged when the fingerprint of its section is (when none of its values were handed out for changing, see iniSection::keptFingerprint()),
+    // or else when the hash of the value itself is
+    // The values are looked up without counting (see setAccessCounting()), so using the cache doesn't look like reading all those values
+    class iniFile::expansionCache
+    {
+        public:
+            // A value which is used by an expanded value, identified by name
+            struct dependency
+            {
+                std::string section;
+                std::string name;
+                unsigned long long key;             // See cacheKey(), to quickly tell dependencies apart
+                unsigned long long sectionHash;     // Fingerprint of the section when the value was used, or 0 if it didn't keep one
+                unsigned long long hash;            // Hash of the raw value when it was used
+            };
+
+            struct entry
+            {
+                std::string expanded;
+                std::vector<dependency> dependencies;   // The value itself first, then every value it refers to (directly or indirectly), each one once
+            };
+
+            // Expand value (which is in section), stack holds the values which are being expanded to find cycles
+            // The values the result depends on are added to dependencies (the ones which aren't in it already)
+            std::string expand(const iniFile& file, const iniSection& section, const iniValue& value, std::vector<const iniValue*>& stack, std::vector<dependency>& dependencies)
+            {
+                // Use the cached result if nothing it depends on has changed
+                const unsigned long long key=cacheKey(section.nameData(), section.nameLength(), value.nameData(), value.nameLength());
+                std::unordered_map<unsigned long long, entry>::const_iterator cached=entries.find(key);
+                if(cached!=entries.end() && valid(file, cached->second, section, value))
+                {
+                    addDependencies(dependencies, cached->second.dependencies, file.caseSensitive);
+                    return cached->second.expanded;
+                }
+
+                entry result;
+                result.dependencies.push_back(makeDependency(key, section, value));
+                stack.push_back(&value);
+                const char* raw=value.valueData();
+                const size_t length=value.valueLength();
+                result.expanded.reserve(length);
+                for(size_t pos=0; pos<length; pos++)
+                {
+                    // Copy everything, except for $$ (which becomes $) and references
+                    if(raw[pos]!='$' || pos+1==length || (raw[pos+1]!='$' && raw[pos+1]!='{'))
+                        result.expanded+=raw[pos];
+                    else if(raw[pos+1]=='$')
+                        result.expanded+=raw[pos++];
+                    else
+                    {
+                        // Split the reference in the section and the name, and look up the value it refers to
+                        const char* end=static_cast<const char*>(std::memchr(raw+pos+2, '}', length-pos-2));
+                        const std::string reference(raw+pos+2, end ? end : raw+length);
+                        const size_t colon=reference.find(':');
+                        if(end==0 || colon==std::string::npos)
+                            throw interpolationError(reference, interpolationError::badReference);
+                        const size_t sectionPos=file.findSection(reference.data(), colon);
+                        if(sectionPos==file.sections.size())
+                            throw interpolationError(reference, interpolationError::unknownReference);
+                        const iniSection& targetSection=file.sections[sectionPos];
+                        const iniValue* target=targetSection.existingValue(reference.substr(colon+1));
+                        if(target==0)
+                            throw interpolationError(reference, interpolationError::unknownReference);
+                        if(std::find(stack.begin(), stack.end(), target)!=stack.end())
+                            throw interpolationError(reference, interpolationError::cyclicReference);
+
+                        result.expanded+=expand(file, targetSection, *target, stack, result.dependencies);
+                        pos=end-raw;
+                    }
+                }
+                stack.pop_back();
+
+                addDependencies(dependencies, result.dependencies, file.caseSensitive);
+                entry& stored=entries[key];
+                stored.expanded.swap(result.expanded);
+                stored.dependencies.swap(result.dependencies);
+                return stored.expanded;
+            }
+
+            std::mutex lock;
+            std::unordered_map<unsigned long long, entry> entries;     // By the hash of the section and value name
+
+        private:
+            static unsigned long long cacheKey(const char* section, const size_t& sectionLength, const char* name, const size_t& nameLength)
+            { return (static_cast<unsigned long long>(diniPrivate::hashName(section, sectionLength))<<32) | diniPrivate::hashName(name, nameLength); }
+
+            static dependency makeDependency(const unsigned long long& key, const iniSection& section, const iniValue& value)
+            {
+                dependency out;
+                out.section.assign(section.nameData(), section.nameLength());
+                out.name.assign(value.nameData(), value.nameLength());
+                out.key=key;
+                out.sectionHash=section.keptFingerprint();
+                out.hash=diniPrivate::hashData(value.valueData(), value.valueLength());
+                return out;
+            }
+
+            // Add the dependencies in from to out, leaving out the ones which are in out already
+            // Without this a value that's referred to along several paths would be added once for every path, which can grow exponentially
+            static void addDependencies(std::vector<dependency>& out, const std::vector<dependency>& from, const bool& caseSensitive)
+            {
+                for(std::vector<dependency>::const_iterator pos=from.begin(); pos!=from.end(); ++pos)
+                {
+                    bool found=false;
+                    for(std::vector<dependency>::const_iterator existing=out.begin(); existing!=out.end() && !found; ++existing)
+                        found=existing->key==pos->key && diniPrivate::sameName(existing->section.data(), existing->section.length(), pos->section.data(), pos->section.length(), caseSensitive) &&
+                              diniPrivate::sameName(existing->name.data(), existing->name.length(), pos->name.data(), pos->name.length(), caseSensitive);
+                    if(!found)
+                        out.push_back(*pos);
+                }
+            }
+
+            // Check whether the entry belongs to value (different names can have the same key), and whether everything it depends on is unchanged
+            static bool valid(const iniFile& file, const entry& cached, const iniSection& section, const iniValue& value)
+            {
+                const dependency& self=cached.dependencies.front();
+                if(!diniPrivate::sameName(self.section.data(), self.section.length(), section.nameData(), section.nameLength(), file.caseSensitive) ||
+                   !diniPrivate::sameName(self.name.data(), self.name.length(), value.nameData(), value.nameLength(), file.caseSensitive))
+                    return false;
+                for(std::vector<dependency>::const_iterator pos=cached.dependencies.begin(); pos!=cached.dependencies.end(); ++pos)
+                {
+                    const size_t sectionPos=file.findSection(pos->section.data(), pos->section.length());
+                    if(sectionPos==file.sections.size())
+                        return false;
+                    const iniSection& dependencySection=file.sections[sectionPos];
+                    if(pos->sectionHash!=0 && dependencySection.keptFingerprint()==pos->sectionHash)
+                        continue;
+                    const iniValue* dependencyValue=dependencySection.existingValue(pos->name);
+                    if(dependencyValue==0 || diniPrivate::hashData(dependencyValue->valueData(), dependencyValue->valueLength())!=pos->hash)
+                        return false;
+                }
+                return true;
+            }
+    };
+
+// iniFile::includeCache
+    // Every entry holds a parsed file, together with the state (time and size) of that file and all files it includes when it was parsed,
+    // the entry is only used when none of those files have changed since
+    class iniFile::includeCache
+    {
+        public:
+            struct entry
+            {
+                std::vector<includeStamp> files;    // The file itself first, then every file it includes (directly or indirectly)
+                iniFile file;
+            };
+
+            typedef std::shared_future<std::shared_ptr<const entry> > future;
+
+            // Start loading the file at filename (see load()), on a new thread when fewer than loaderLimit() included files are being loaded at the moment
+            // If not, it's loaded by the thread that waits for it (when it calls get()), so nested includes can never wait for a thread that can't start
+            static future start(const std::string& filename, const std::vector<std::string>& includeChain)
+            {
+                if(loading.fetch_add(1)>=loaderLimit())
+                {
+                    loading.fetch_sub(1);
+                    return std::async(std::launch::deferred, &includeCache::load, filename, includeChain).share();
+                }
+                return std::async(std::launch::async, [filename, includeChain]()
+                {
+                    loaderSlot release;
+                    return load(filename, includeChain);
+                }).share();
+            }
+
+            // Get the parsed file at filename (which has to be a canonical path), which is only parsed if it isn't in the cache or has changed since
+            // includeChain holds the files including it, to find cycles
+            static std::shared_ptr<const entry> load(const std::string& filename, const std::vector<std::string>& includeChain) throw(fileError, errorCorrupted)
+            {
+                includeStamp stamp;
+                stamp.filename=filename;
+                if(diniPrivate::fileInfo(filename, stamp.modified, stamp.size)!=diniPrivate::ioOk)
+                    throw fileError(filename, fileError::openForReadingError);
+
+                // Look in the cache first (the files are checked without holding the lock)
+                std::shared_ptr<const entry> cached;
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    std::map<std::string, slot>::iterator pos=entries.find(filename);
+                    if(pos!=entries.end())
+                    {
+                        cached=pos->second.cached;
+                        pos->second.lastUse=++uses;
+                    }
+                }
+                if(cached && unchanged(*cached))
+                    return cached;
+
+                // Read and parse the file, with this file added to the chain of files being included
+                std::string data;
+                switch(diniPrivate::readWholeFile(filename, data))
+                {
+                    case diniPrivate::ioOk:             break;
+                    case diniPrivate::ioOpenError:      throw fileError(filename, fileError::openForReadingError);
+                    case diniPrivate::ioError:          throw fileError(filename, fileError::readError);
+                }
+                std::shared_ptr<entry> result=std::make_shared<entry>();
+                result->files.push_back(stamp);
+                std::vector<std::string> chain(includeChain);
+                chain.push_back(filename);
+                result->file.parse(data, filename, chain, result->files, sectionFilter(), 0);
+
+                std::lock_guard<std::mutex> guard(lock);
+                slot& stored=entries[filename];
+                stored.cached=result;
+                stored.lastUse=++uses;
+                evict();
+                return result;
+            }
+
+            static void clear()
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                entries.clear();
+            }
+
+            static void setLimit(const size_t& files)
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                limit=files;
+                evict();
+            }
+
+        private:
+            // Check whether none of the files the entry was made from have changed
+            static bool unchanged(const entry& cached)
+            {
+                for(std::vector<includeStamp>::const_iterator pos=cached.files.begin(); pos!=cached.files.end(); ++pos)
+                {
+                    unsigned long long modified=0, size=0;
+                    if(diniPrivate::fileInfo(pos->filename, modified, size)!=diniPrivate::ioOk || modified!=pos->modified || size!=pos->size)
+                        return false;
+                }
+                return true;
+            }
+
+            // Remove the files that were used longest ago until there are at most limit files left, lock has to be held
+            // Going through all files to find the oldest is fine, as this only happens when a file is parsed
+            static void evict()
+            {
+                while(entries.size()>limit)
+                {
+                    std::map<std::string, slot>::iterator oldest=entries.begin();
+                    for(std::map<std::string, slot>::iterator pos=entries.begin(); pos!=entries.end(); ++pos)
+                    {
+                        if(pos->second.lastUse<oldest->second.lastUse)
+                            oldest=pos;
+                    }
+                    entries.erase(oldest);
+                }
+            }
+
+            // The number of included files that may be loaded on threads of their own at the same time (by all files together)
+            static unsigned int loaderLimit()
+            {
+                const unsigned int cores=std::thread::hardware_concurrency();
+                return cores<2 ? 2 : cores;
+            }
+            // Gives the place of a loader back when the loader is done (or fails)
+            struct loaderSlot
+            {
+                ~loaderSlot()
+                { loading.fetch_sub(1); }
+            };
+
+            struct slot
+            {
+                std::shared_ptr<const entry> cached;
+                unsigned long long lastUse;
+            };
+
+            static std::mutex lock;
+            static std::map<std::string, slot> entries;     // By canonical path
+            static unsigned long long uses;                 // Counts the uses of entries, to find the one used longest ago
+            static size_t limit;
+            static std::atomic<unsigned int> loading;       // The number of included files being loaded on threads of their own
+    };
+
+    std::mutex iniFile::includeCache::lock;
+    std::map<std::string, iniFile::includeCache::slot> iniFile::includeCache::entries;
+    unsigned long long iniFile::includeCache::uses=0;
+    size_t iniFile::includeCache::limit=256;
+    std::atomic<unsigned int> iniFile::includeCache::loading(0);
+
+// iniFile::expansionCacheHolder
+    // Public:
+        iniFile::expansionCacheHolder::expansionCacheHolder()
+            :cache(new expansionCache){}
+        iniFile::expansionCacheHolder::expansionCacheHolder(const expansionCacheHolder&)
+            :cache(new expansionCache){}
+        iniFile::expansionCacheHolder::~expansionCacheHolder()
+        { delete cache; }
+        iniFile::expansionCacheHolder& iniFile::expansionCacheHolder::operator=(const expansionCacheHolder&)
+        {
+            // The cache isn't copied, but it has to be emptied as it belongs to the old contents
+            std::lock_guard<std::mutex> guard(cache->lock);
+            cache->entries.clear();
+            return *this;
+        }
 
 // iniFile
     // Public:
-        iniSection& iniFile::getSection(const std::string& name)
+        iniFile::iniFile()
+            :caseSensitive(true), typeInference(false), tombstoneCount(0), tombstoneLimit(0){}
+
+        bool iniFile::isCaseSensitive() const
+        { return caseSensitive; }
+        void iniFile::setCaseSensitive(const bool& caseSensitive)
         {
-            // Search for the section, and if we find it, return it
+            // Pass the setting on to all sections, and sort the index again (the hashes already ignore case)
+            if(this->caseSensitive==caseSensitive)
+                return;
+            this->caseSensitive=caseSensitive;
             for(std::vector<iniSection>::iterator pos=sections.begin(); pos!=sections.end(); ++pos)
+                pos->setCaseSensitive(caseSensitive);
+            diniPrivate::indexRebuild(nameIndex, sections, caseSensitive);
+        }
+
+        bool iniFile::infersTypes() const
+        { return typeInference; }
+        void iniFile::setInferTypes(const bool& inferTypes)
+        {
+            typeInference=inferTypes;
+            if(!inferTypes)
+                return;
+            // Inferring a type doesn't change the text of a value, so the values are used directly (the fingerprints stay valid)
+            for(std::vector<iniSection>::iterator section=sections.begin(); section!=sections.end(); ++section)
+            {
+                for(std::vector<iniValue>::iterator value=section->values.begin(); value!=section->values.end(); ++value)
+                    value->inferType();
+            }
+        }
+
+        bool iniFile::countsAccesses() const
+        { return counter!=0; }
+        void iniFile::setAccessCounting(const bool& countAccesses)
+        {
+            // Every section gets the new counters, or forgets its counters when counting is turned off
+            if(countsAccesses()==countAccesses)
+                return;
+            if(countAccesses)
+                counter=std::make_shared<accessCounter>();
+            else
+                counter.reset();
+            for(std::vector<iniSection>::iterator section=sections.begin(); section!=sections.end(); ++section)
+                section->startCounting(counter);
+        }
+
+        std::vector<accessCount> iniFile::accessCounts() const
+        {
+            // List the sections and values in the order of the file, and then sort them (keeping that order for equal counts)
+            std::vector<accessCount> result;
+            for(const_iterator section=begin(); section!=end(); ++section)
             {
-                if(name==pos->name())
-                    return *pos;
+                if(!section->counter)
+                    continue;
+                accessCount entry;
+                entry.section=section->name();
+                entry.count=section->counter->total(section->sectionSlot);
+                result.push_back(entry);
+                // The counters follow the stored values (including the ones marked as erased), so go through them by position
+                for(size_t pos=0; pos<section->values.size(); pos++)
+                {
+                    if(section->tombstoneCount!=0 && section->tombstones[pos])
+                        continue;
+                    entry.name=section->values[pos].name();
+                    entry.count=section->counter->total(section->counterSlots[pos]);
+                    result.push_back(entry);
+                }
             }
+            std::stable_sort(result.begin(), result.end(), [](const accessCount& lhs, const accessCount& rhs){ return lhs.count>rhs.count; });
+            return result;
+        }
+        std::vector<accessCount> iniFile::hottestKeys(const size_t& count) const
+        {
+            std::vector<accessCount> result=accessCounts();
+            result.erase(std::remove_if(result.begin(), result.end(), [](const accessCount& entry){ return entry.name.empty(); }), result.end());
+            if(result.size()>count)
+                result.resize(count);
+            return result;
+        }
+        std::vector<accessCount> iniFile::unreadKeys() const
+        {
+            std::vector<accessCount> result;
+            for(const_iterator section=begin(); section!=end(); ++section)
+            {
+                if(!section->counter)
+                    continue;
+                for(size_t pos=0; pos<section->values.size(); pos++)
+                {
+                    if(section->tombstoneCount!=0 && section->tombstones[pos])
+                        continue;
+                    if(section->counter->total(section->counterSlots[pos])==0)
+                    {
+                        accessCount entry;
+                        entry.section=section->name();
+                        entry.name=section->values[pos].name();
+                        entry.count=0;
+                        result.push_back(entry);
+                    }
+                }
+            }
+            return result;
+        }
+        void iniFile::resetAccessCounts()
+        {
+            if(counter)
+                counter->reset();
+        }
+
+        iniSection& iniFile::getSection(const std::string& name)
+        {
+            // Search for the section, and if we find it, return it
+            if(iniSection* section=tryGetSection(name))
+                return *section;
             // If we don't find it, create an empty section with the name and return that empty section
-            sections.push_back(iniSection(name));
-            return sections.back();
+            return appendSection(iniSection(name));
         }
 
         iniSection iniFile::getSection(const std::string& name) const throw(unknownName)
         {
             // Search for the section, if we find it, return it, if not, throw an error
-            for(std::vector<iniSection>::const_iterator pos=sections.begin(); pos!=sections.end(); ++pos)
-            {
-                if(name==pos->name())
-                    return *pos;
-            }
+            if(const iniSection* section=tryGetSection(name))
+                return *section;
             throw unknownName(name);
         }
 
+        iniSection* iniFile::tryGetSection(const std::string& name)
+        {
+            // Search for the section, if we find it, return a pointer to it, if not, return a null pointer
+            const size_t pos=findSection(name.data(), name.length());
+            if(pos!=sections.size() && sections[pos].counter)
+                sections[pos].counter->count(sections[pos].sectionSlot);
+            return pos!=sections.size() ? &sections[pos] : 0;
+        }
+
+        const iniSection* iniFile::tryGetSection(const std::string& name) const
+        {
+            // Search for the section, if we find it, return a pointer to it, if not, return a null pointer
+            const size_t pos=findSection(name.data(), name.length());
+            if(pos!=sections.size() && sections[pos].counter)
+                sections[pos].counter->count(sections[pos].sectionSlot);
+            return pos!=sections.size() ? &sections[pos] : 0;
+        }
+
+        iniSection& iniFile::getSection(const iniKey& key)
+        {
+            // Search for the section by its key, and if we find it, return it
+            if(iniSection* section=tryGetSection(key))
+                return *section;
+            // If we don't find it, create an empty section with the name and return that empty section
+            return appendSection(iniSection(key.toString()));
+        }
+
+        iniSection iniFile::getSection(const iniKey& key) const throw(unknownName)
+        {
+            // Search for the section by its key, if we find it, return it, if not, throw an error
+            if(const iniSection* section=tryGetSection(key))
+                return *section;
+            throw unknownName(key.toString());
+        }
+
+        iniSection* iniFile::tryGetSection(const iniKey& key)
+        {
+            // The key already has its hash, so the name doesn't have to be hashed again
+            const size_t pos=findSection(key.nameData(), key.nameLength(), key.nameHash());
+            if(pos!=sections.size() && sections[pos].counter)
+                sections[pos].counter->count(sections[pos].sectionSlot);
+            return pos!=sections.size() ? &sections[pos] : 0;
+        }
+
+        const iniSection* iniFile::tryGetSection(const iniKey& key) const
+        {
+            // The key already has its hash, so the name doesn't have to be hashed again
+            const size_t pos=findSection(key.nameData(), key.nameLength(), key.nameHash());
+            if(pos!=sections.size() && sections[pos].counter)
+                sections[pos].counter->count(sections[pos].sectionSlot);
+            return pos!=sections.size() ? &sections[pos] : 0;
+        }
+
         void iniFile::setSection(const std::string& name, const iniSection& section)
         {
             // Search for the section, if we find it, assign the new section to it
-            for(std::vector<iniSection>::iterator pos=sections.begin(); pos!=sections.end(); ++pos)
-            {
-                if(pos->name()==name)
-                {
-                    *pos=section;
-                    return;
-                }
-            }
             // If we don't find it, just add the section to the list
-            sections.push_back(iniSection(name, section));
+            // The lookup isn't counted, as this doesn't read the section
+            const size_t pos=findSection(name.data(), name.length());
+            if(pos!=sections.size())
+                sections[pos]=section;
+            else
+                appendSection(iniSection(name, section));
         }
 
         bool iniFile::rename(const std::string& oldName, const std::string& newName)
         {
-            // If the new name already exists, or the new name isn't valid return false
-            if(sectionExists(newName) || !diniPrivate::validName(newName))
+            // If the new name isn't valid, or the section doesn't exist, return false
+            const size_t pos=findSection(oldName.data(), oldName.length());
+            if(pos==sections.size() || !diniPrivate::validName(newName))
                 return false;
-            // Search for the section and change it's name, return if succesfull (which will always be because we've allready checked if the name is valid)
-            for(std::vector<iniSection>::iterator pos=sections.begin(); pos!=sections.end(); ++pos)
-            {
-                if(oldName==pos->name())
-                    return pos->setName(newName);
-            }
-            return false;
+            // If the new name already exists return false, unless only the case of this section's name changes
+            const size_t existing=findSection(newName.data(), newName.length());
+            if(existing!=sections.size() && (existing!=pos || diniPrivate::sameName(sections[pos].nameData(), sections[pos].nameLength(), newName.data(), newName.length(), true)))
+                return false;
+            // Change its name, update its hash and move it to its new place in the index
+            sections[pos].setName(newName);
+            nameHashes[pos]=diniPrivate::hashName(newName.data(), newName.length());
+            diniPrivate::filterRenamed(nameFilter, nameHashes, pos);
+            diniPrivate::indexRename(nameIndex, sections, pos, caseSensitive);
+            return true;
         }
 
         bool iniFile::erase(const std::string& name)
         {
             // Search for the section, if we find it we erase it and return true, if not we return false
-            for(std::vector<iniSection>::iterator pos=sections.begin(); pos!=sections.end(); ++pos)
+            const size_t pos=findSection(name.data(), name.length());
+            if(pos==sections.size())
+                return false;
+            if(tombstoneLimit==0)
             {
-                if(name==pos->name())
-                {
-                    sections.erase(pos);
-                    return true;
-                }
+                erase(iterator(&sections[0], pos, sections.size(), 0));
+                return true;
             }
-            return false;
+            // With deferred erasing, only mark the section, until there are too many marked sections
+            if(tombstones.empty())
+                tombstones.assign(sections.size(), false);
+            tombstones[pos]=true;
+            if(++tombstoneCount>tombstoneLimit)
+                compact();
+            return true;
         }
         void iniFile::erase(const iterator& pos)
-        { sections.erase(pos); }
+        { erase(pos, pos+1); }
         void iniFile::erase(const iterator& first, const iterator& last)
-        { sections.erase(first, last); }
+        {
+            const size_t from=position(first);
+            const size_t to=position(last);
+            // Sections in the range which are already marked as erased don't have to be marked anymore
+            if(!tombstones.empty())
+            {
+                tombstoneCount-=std::count(tombstones.begin()+from, tombstones.begin()+to, true);
+                tombstones.erase(tombstones.begin()+from, tombstones.begin()+to);
+                if(tombstoneCount==0)
+                    tombstones.clear();
+            }
+            diniPrivate::indexErase(nameIndex, from, to);
+            nameHashes.erase(nameHashes.begin()+from, nameHashes.begin()+to);
+            diniPrivate::filterRebuild(nameFilter, nameHashes);
+            diniPrivate::eraseItems(sections, sections.begin()+from, sections.begin()+to);
+        }
+
+        void iniFile::setEraseLimit(const size_t& limit)
+        {
+            tombstoneLimit=limit;
+            if(tombstoneCount>tombstoneLimit)
+                compact();
+        }
+        size_t iniFile::eraseLimit() const
+        { return tombstoneLimit; }
+
+        void iniFile::compact()
+        {
+            if(tombstoneCount!=0)
+                removeErased(tombstones);
+        }
+
+        memoryReport iniFile::memoryUsage() const
+        {
+            memoryReport result;
+            result.sections.reserve(sections.size());
+            for(std::vector<iniSection>::const_iterator section=sections.begin(); section!=sections.end(); ++section)
+                result.sections.push_back(section->memoryUsage());
+            result.objects=sizeof(iniFile)+diniPrivate::vectorBytes(sections);
+            result.lookup=diniPrivate::vectorBytes(nameHashes)+diniPrivate::vectorBytes(nameFilter)+diniPrivate::vectorBytes(nameIndex)+diniPrivate::vectorBytes(tombstones);
+            result.slack=diniPrivate::vectorSlack(sections)+diniPrivate::vectorSlack(nameHashes)+diniPrivate::vectorSlack(nameFilter)+
+                         diniPrivate::vectorSlack(nameIndex)+diniPrivate::vectorSlack(tombstones);
+            return result;
+        }
+
+        void iniFile::shrinkToFit()
+        {
+            // Shrink the sections after they've been copied into a vector of the right size, which would give them room to grow again
+            compact();
+            diniPrivate::shrinkVector(sections);
+            for(std::vector<iniSection>::iterator section=sections.begin(); section!=sections.end(); ++section)
+                section->shrinkToFit();
+            diniPrivate::shrinkVector(nameHashes);
+            diniPrivate::shrinkVector(nameFilter);
+            diniPrivate::shrinkVector(nameIndex);
+            diniPrivate::shrinkVector(tombstones);
+        }
 
         bool iniFile::sectionExists(const std::string& name) const
+        { return tryGetSection(name)!=0; }
+
+        iniFile::range iniFile::findPrefix(const std::string& prefix)
+        {
+            compact();
+            std::pair<const size_t*, const size_t*> found=diniPrivate::indexPrefixRange(nameIndex, sections, prefix, caseSensitive);
+            return range(sections.empty() ? 0 : &sections[0], found.first, found.second, "", caseSensitive);
+        }
+        iniFile::const_range iniFile::findPrefix(const std::string& prefix) const
+        {
+            std::pair<const size_t*, const size_t*> found=diniPrivate::indexPrefixRange(nameIndex, sections, prefix, caseSensitive);
+            return const_range(sections.empty() ? 0 : &sections[0], found.first, found.second, "", caseSensitive, erasedMarks());
+        }
+
+        iniFile::range iniFile::findMatching(const std::string& pattern)
+        {
+            compact();
+            // Look up the range of sections starting with the literal part of the pattern, the range will filter out the sections which don't match
+            std::pair<const size_t*, const size_t*> found=diniPrivate::indexPrefixRange(nameIndex, sections, diniPrivate::globPrefix(pattern), caseSensitive);
+            return range(sections.empty() ? 0 : &sections[0], found.first, found.second, pattern, caseSensitive);
+        }
+        iniFile::const_range iniFile::findMatching(const std::string& pattern) const
+        {
+            // Look up the range of sections starting with the literal part of the pattern, the range will filter out the sections which don't match
+            std::pair<const size_t*, const size_t*> found=diniPrivate::indexPrefixRange(nameIndex, sections, diniPrivate::globPrefix(pattern), caseSensitive);
+            return const_range(sections.empty() ? 0 : &sections[0], found.first, found.second, pattern, caseSensitive, erasedMarks());
+        }
+
+        size_t iniFile::getColumn(const std::string& name, std::vector<double>& out, const double& defaultValue) const
+        { return diniPrivate::extractColumn(begin(), end(), name, out, defaultValue); }
+        size_t iniFile::getColumn(const std::string& name, std::vector<int>& out, const int& defaultValue) const
+        { return diniPrivate::extractColumn(begin(), end(), name, out, defaultValue); }
+        size_t iniFile::getColumn(const const_range& selection, const std::string& name, std::vector<double>& out, const double& defaultValue) const
+        { return diniPrivate::extractColumn(selection.begin(), selection.end(), name, out, defaultValue); }
+        size_t iniFile::getColumn(const const_range& selection, const std::string& name, std::vector<int>& out, const int& defaultValue) const
+        { return diniPrivate::extractColumn(selection.begin(), selection.end(), name, out, defaultValue); }
+
+        void iniFile::clear()
         {
-            // Search for the section, return true if we find it, if not: return false
-            for(std::vector<iniSection>::const_iterator pos=sections.begin(); pos!=sections.end(); ++pos)
+            sections.clear();
+            nameHashes.clear();
+            nameFilter.clear();
+            nameIndex.clear();
+            tombstones.clear();
+            tombstoneCount=0;
+            // The counters of the removed sections aren't needed anymore, so count in new ones
+            if(counter)
+                counter=std::make_shared<accessCounter>();
+            std::lock_guard<std::mutex> guard(expansions.cache->lock);
+            expansions.cache->entries.clear();
+        }
+
+        unsigned long long iniFile::fingerprint() const
+        {
+            // The sections which are marked as erased are skipped
+            unsigned long long hash=diniPrivate::hashData(0, 0);
+            for(size_t pos=0; pos<sections.size(); pos++)
             {
-                if(name==pos->name())
-                    return true;
+                if(!tombstones.empty() && tombstones[pos])
+                    continue;
+                const unsigned long long sectionHash=sections[pos].fingerprint();
+                hash=diniPrivate::hashEntry(hash, sections[pos].nameData(), sections[pos].nameLength(), reinterpret_cast<const char*>(&sectionHash), sizeof(sectionHash));
             }
-            return false;
+            return hash;
         }
 
-        void iniFile::clear()
-        { sections.clear(); }
+        std::vector<std::string> iniFile::changedSections(const iniFile& other) const
+        {
+            // Each section is looked up in the other file by its hash, so this only compares fingerprints
+            std::vector<std::string> result;
+            for(size_t pos=0; pos<sections.size(); pos++)
+            {
+                if(!tombstones.empty() && tombstones[pos])
+                    continue;
+                const size_t otherPos=other.findSection(sections[pos].nameData(), sections[pos].nameLength());
+                if(otherPos==other.sections.size() || other.sections[otherPos].fingerprint()!=sections[pos].fingerprint())
+                    result.push_back(sections[pos].name());
+            }
+            for(size_t pos=0; pos<other.sections.size(); pos++)
+            {
+                if(!other.tombstones.empty() && other.tombstones[pos])
+                    continue;
+                if(findSection(other.sections[pos].nameData(), other.sections[pos].nameLength())==sections.size())
+                    result.push_back(other.sections[pos].name());
+            }
+            return result;
+        }
+
+        std::string iniFile::getExpanded(const std::string& section, const std::string& name) const throw(unknownName, interpolationError)
+        {
+            // Find the value, and expand it (the cache may be used by several threads reading this file at once)
+            const size_t sectionPos=findSection(section.data(), section.length());
+            if(sectionPos==sections.size())
+                throw unknownName(section);
+            const iniValue* value=sections[sectionPos].tryGetValue(name);
+            if(value==0)
+                throw unknownName(name);
+            std::vector<const iniValue*> stack;
+            std::vector<expansionCache::dependency> dependencies;
+            std::lock_guard<std::mutex> guard(expansions.cache->lock);
+            return expansions.cache->expand(*this, sections[sectionPos], *value, stack, dependencies);
+        }
+
+        bool iniFile::apply(const iniBatch& batch)
+        {
+            // Check all names before changing anything, so either the whole batch is applied, or nothing at all
+            typedef std::vector<iniBatch::operation>::const_iterator operationIterator;
+            for(operationIterator op=batch.operations.begin(); op!=batch.operations.end(); ++op)
+            {
+                if(!diniPrivate::validName(op->section))
+                    return false;
+                if((op->type==iniBatch::opSetValue || op->type==iniBatch::opEraseValue) && !diniPrivate::validName(op->name))
+                    return false;
+            }
+            // The index is used to find the sections, so it may not contain any erased sections
+            compact();
+
+            // Sort the changes by section (keeping the changes to the same section in order), so each section only has to be looked up once
+            const std::vector<iniBatch::operation>& ops=batch.operations;
+            std::vector<size_t> order(ops.size());
+            for(size_t i=0; i<order.size(); i++)
+                order[i]=i;
+            const bool caseSensitive=this->caseSensitive;
+            std::stable_sort(order.begin(), order.end(), [&ops, caseSensitive](const size_t& lhs, const size_t& rhs)
+            {
+                return diniPrivate::compareNames(ops[lhs].section.data(), ops[lhs].section.length(),
+                                                 ops[rhs].section.data(), ops[rhs].section.length(), caseSensitive)<0;
+            });
+
+            // Go through the changes per section
+            // Existing sections are changed in place or marked as erased, new sections are collected first
+            std::vector<bool> erased(sections.size(), false);
+            bool anyErased=false;
+            std::vector<iniSection> added;
+            std::vector<std::pair<bool, const iniValue*> > valueChanges;
+            for(size_t first=0, last=0; first<order.size(); first=last)
+            {
+                const std::string& name=ops[order[first]].section;
+                const size_t pos=diniPrivate::indexFind(nameIndex, sections, name.data(), name.length(), caseSensitive);
+
+                // Replay the changes to find out what happens to the section: whether it exists in the end,
+                // whether its old values are thrown away (and replaced by which section), and which values are changed afterwards
+                bool exists=pos!=sections.size();
+                bool reset=false;
+                const iniSection* replacement=0;
+                const std::string* createdAs=&name;
+                valueChanges.clear();
+                for(last=first; last<order.size() && diniPrivate::sameName(ops[order[last]].section.data(), ops[order[last]].section.length(),
+                                                                           name.data(), name.length(), caseSensitive); last++)
+                {
+                    const iniBatch::operation& op=ops[order[last]];
+                    switch(op.type)
+                    {
+                        case iniBatch::opEraseSection:
+                            exists=false;
+                            reset=true;
+                            replacement=0;
+                            valueChanges.clear();
+                        break;
+                        case iniBatch::opSetSection:
+                            exists=true;
+                            reset=true;
+                            replacement=&batch.sections[op.data];
+                            createdAs=&op.section;
+                            valueChanges.clear();
+                        break;
+                        case iniBatch::opSetValue:
+                            if(!exists)
+                            {
+                                exists=true;
+                                reset=true;
+                                replacement=0;
+                                createdAs=&op.section;
+                                valueChanges.clear();
+                            }
+                            valueChanges.push_back(std::make_pair(false, &batch.values[op.data]));
+                        break;
+                        case iniBatch::opEraseValue:
+                            if(exists)
+                                valueChanges.push_back(std::make_pair(true, &batch.values[op.data]));
+                        break;
+                    }
+                }
+
+                iniSection* target=0;
+                if(pos!=sections.size())
+                {
+                    if(!exists)
+                    {
+                        anyErased=erased[pos]=true;
+                        continue;
+                    }
+                    target=&sections[pos];
+                }
+                else
+                {
+                    if(!exists)
+                        continue;
+                    added.push_back(iniSection(*createdAs));
+                    added.back().setCaseSensitive(caseSensitive);
+                    target=&added.back();
+                }
+                if(reset)
+                {
+                    if(replacement)
+                        *target=*replacement;
+                    else
+                        target->clear();
+                }
+                if(!valueChanges.empty())
+                    target->applyValues(valueChanges);
+            }
+
+            // Remove the erased sections and add the new ones, and then update the index once
+            if(anyErased)
+                diniPrivate::compactItems(sections, nameHashes, erased, added.size());
+            else
+            {
+                sections.reserve(sections.size()+added.size());
+                nameHashes.reserve(sections.size()+added.size());
+            }
+            for(std::vector<iniSection>::const_iterator section=added.begin(); section!=added.end(); ++section)
+            {
+                sections.push_back(*section);
+                nameHashes.push_back(diniPrivate::hashName(section->nameData(), section->nameLength()));
+                if(counter)
+                    sections.back().startCounting(counter);
+            }
+            if(anyErased || !added.empty())
+            {
+                diniPrivate::filterRebuild(nameFilter, nameHashes);
+                diniPrivate::indexRebuild(nameIndex, sections, caseSensitive);
+            }
+            return true;
+        }
+
+        iniSnapshot iniFile::freeze() const
+        { return iniSnapshot(*this); }
 
         iniSection& iniFile::operator[](const std::string& name)
         { return getSection(name); }
         iniSection iniFile::operator[](const std::string& name) const
         { return getSection(name); }
+        iniSection& iniFile::operator[](const iniKey& key)
+        { return getSection(key); }
+        iniSection iniFile::operator[](const iniKey& key) const
+        { return getSection(key); }
 
         iniFile::iterator iniFile::begin()
-        { return sections.begin(); }
+        {
+            compact();
+            return iterator(sections.empty() ? 0 : &sections[0], 0, sections.size(), 0);
+        }
         iniFile::const_iterator iniFile::begin() const
-        { return sections.begin(); }
+        { return const_iterator(sections.empty() ? 0 : &sections[0], 0, sections.size(), erasedMarks()); }
         iniFile::reverse_iterator iniFile::rbegin()
-        { return sections.rbegin(); }
+        { return reverse_iterator(end()); }
         iniFile::const_reverse_iterator iniFile::rbegin() const
-        { return sections.rbegin(); }
+        { return const_reverse_iterator(end()); }
 
         iniFile::iterator iniFile::end()
-        { return sections.end(); }
+        {
+            compact();
+            return iterator(sections.empty() ? 0 : &sections[0], sections.size(), sections.size(), 0);
+        }
         iniFile::const_iterator iniFile::end() const
-        { return sections.end(); }
+        { return const_iterator(sections.empty() ? 0 : &sections[0], sections.size(), sections.size(), erasedMarks()); }
         iniFile::reverse_iterator iniFile::rend()
-        { return sections.rend(); }
+        { return reverse_iterator(begin()); }
         iniFile::const_reverse_iterator iniFile::rend() const
-        { return sections.rend(); }
+        { return const_reverse_iterator(begin()); }
 
         void iniFile::saveToFile(const std::string& filename) const throw(fileError)
         {
-            // Open file for writing, and check if it's openend succesfully
-            std::ofstream file(filename.c_str(), std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
-            if(!file.good())
+            // When there's an instrumentation hook, count and time what's done in stats (tracked is a null pointer otherwise)
+            const std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+            ioStats stats(ioStats::opSave, filename);
+            ioStats* tracked=statsHook ? &stats : 0;
+            try
             {
-                file.close();
-                throw fileError(filename, fileError::openForWritingError);
-            }
-
-            // Loop through all sections and write every section to the file
-            for(std::vector<iniSection>::const_iterator pos=sections.begin(); pos!=sections.end(); ++pos)
-            {
-                // If something is wrong, close the file and throw an error
-                if(!file.good())
+                // Open file for writing, and check if it's openend succesfully
+                diniPrivate::fileWriter file;
                 {
-                    file.close();
-                    throw fileError(filename, fileError::writeError);
+                    diniPrivate::phaseTimer timer(tracked ? &tracked->ioTime : 0);
+                    if(file.open(filename)!=diniPrivate::ioOk)
+                        throw fileError(filename, fileError::openForWritingError);
                 }
-                // Write the section name to the file
-                file<<'['<<pos->name()<<"]\n";
-                // Loop through all values in the section and write each of them to the file
-                for(iniSection::const_iterator pos2=pos->begin(); pos2!=pos->end(); ++pos2)
+
+                // Loop through all sections and write every section to the file (the const iterators skip the ones marked as erased)
+                // Each section is first put in a buffer, which is then passed to the (buffered) file at once
+                std::string buffer;
+                for(const_iterator pos=begin(); pos!=end(); ++pos)
                 {
-                    // Write the name of the value to the file
-                    file<<pos2->name()<<'=';
-                    // Get the value, and escape any special characters
-                    std::string value=pos2->toString();
-                    for(std::string::const_iterator strPos=value.begin(); strPos!=value.end(); ++strPos)
                     {
-                        switch(*strPos)
-                        {
-                            case '\\':
-                            case ';':
-                            case '=':    file<<'\\'<<*strPos;   break;
-
-                            case '\n':  file<<"\\n";            break;
-                            case '\r':  file<<"\\r";            break;
-                            case '\0':  file<<"\\0";            break;
-                            default:    file<<*strPos;          break;
-                        }
+                        diniPrivate::phaseTimer timer(tracked ? &tracked->valueTime : 0);
+                        buffer.clear();
+                        diniPrivate::appendSection(buffer, *pos);
                     }
-                    file<<'\n';
+                    // If something is wrong, close the file and throw an error
+                    diniPrivate::phaseTimer timer(tracked ? &tracked->ioTime : 0);
+                    if(file.write(buffer)!=diniPrivate::ioOk)
+                        throw fileError(filename, fileError::writeError);
+                    if(tracked)
+                        tracked->bytes+=buffer.size();
                 }
-                file<<'\n';
+                diniPrivate::phaseTimer timer(tracked ? &tracked->ioTime : 0);
+                if(file.close()!=diniPrivate::ioOk)
+                    throw fileError(filename, fileError::writeError);
+            }
+            catch(const fileError&)
+            {
+                report(tracked, start, false);
+                throw;
+            }
+
+            // Every escape sequence takes one character more than the character it stands for, and each section takes two lines besides its values
+            if(tracked)
+            {
+                stats.escapes=stats.bytes-countContents(stats);
+                stats.lines=stats.sections*2+stats.values;
             }
-            file.close();
+            report(tracked, start, true);
         }
 
         void iniFile::loadFromFile(const std::string& filename) throw(fileError, errorCorrupted)
+        { loadFromFile(filename, sectionFilter()); }
+
+        void iniFile::loadFromFile(const std::string& filename, const std::vector<std::string>& sectionNames) throw(fileError, errorCorrupted)
+        {
+            // Sort the names, so each section only has to be looked up with a binary search
+            const diniPrivate::stringLess compare(caseSensitive);
+            std::vector<std::string> names(sectionNames);
+            std::sort(names.begin(), names.end(), compare);
+            loadFromFile(filename, [names, compare](const std::string& name){ return std::binary_search(names.begin(), names.end(), name, compare); });
+        }
+
+        void iniFile::loadFromFile(const std::string& filename, const sectionFilter& filter) throw(fileError, errorCorrupted)
         {
-            // Open file for reading, and check if it's opened succesfully
-            std::ifstream file(filename.c_str(), std::ios_base::in | std::ios_base::binary);
-            if(!file.good())
+            // When there's an instrumentation hook, count and time what's done in stats (tracked is a null pointer otherwise)
+            const std::chrono::steady_clock::time_point start=std::chrono::steady_clock::now();
+            ioStats stats(ioStats::opLoad, filename);
+            ioStats* tracked=statsHook ? &stats : 0;
+            try
             {
-                file.close();
-                throw fileError(filename, fileError::openForReadingError);
+                // Read the whole file at once, and check if that went well
+                std::string data;
+                diniPrivate::ioResult result;
+                {
+                    diniPrivate::phaseTimer timer(tracked ? &tracked->ioTime : 0);
+                    result=diniPrivate::readWholeFile(filename, data);
+                }
+                switch(result)
+                {
+                    case diniPrivate::ioOk:             break;
+                    case diniPrivate::ioOpenError:      throw fileError(filename, fileError::openForReadingError);
+                    case diniPrivate::ioError:          throw fileError(filename, fileError::readError);
+                }
+                stats.bytes=data.size();
+
+                // Clear all the data in this object, and parse the data
+                clear();
+                std::vector<includeStamp> included;
+                parse(data, filename, std::vector<std::string>(1, diniPrivate::canonicalPath(filename)), included, filter, tracked);
             }
+            catch(const fileError&)
+            {
+                report(tracked, start, false);
+                throw;
+            }
+            catch(const errorCorrupted&)
+            {
+                report(tracked, start, false);
+                throw;
+            }
+            report(tracked, start, true);
+        }
+
+        void iniFile::clearIncludeCache()
+        { includeCache::clear(); }
+        void iniFile::setIncludeCacheLimit(const size_t& files)
+        { includeCache::setLimit(files); }
+
+        void iniFile::setInstrumentation(const instrumentation& hook)
+        { statsHook=hook; }
+
+        std::future<iniFile> iniFile::loadFromFileAsync(const std::string& filename)
+        {
+            return std::async(std::launch::async, [filename]()
+            {
+                iniFile out;
+                out.loadFromFile(filename);
+                return out;
+            });
+        }
+        std::future<iniFile> iniFile::loadFromFileAsync(const std::string& filename, const executor& exec)
+        {
+            // Wrap the loading in a task, so the loaded file or any error thrown while loading ends up in the future
+            std::shared_ptr<std::packaged_task<iniFile()>> task=std::make_shared<std::packaged_task<iniFile()>>([filename]()
+            {
+                iniFile out;
+                out.loadFromFile(filename);
+                return out;
+            });
+            std::future<iniFile> result=task->get_future();
+            exec([task](){ (*task)(); });
+            return result;
+        }
+
+        std::future<void> iniFile::saveToFileAsync(const std::string& filename) const
+        { return std::async(std::launch::async, [this, filename](){ saveToFile(filename); }); }
+        std::future<void> iniFile::saveToFileAsync(const std::string& filename, const executor& exec) const
+        {
+            // Wrap the saving in a task, so any error thrown while saving ends up in the future
+            std::shared_ptr<std::packaged_task<void()>> task=std::make_shared<std::packaged_task<void()>>([this, filename](){ saveToFile(filename); });
+            std::future<void> result=task->get_future();
+            exec([task](){ (*task)(); });
+            return result;
+        }
 
-            // Clear all the data in this object
-            clear();
+    // Private:
+        bool iniFile::keepSection(const sectionFilter& filter, const std::string& name, const std::string& lineData) const throw(errorCorrupted)
+        {
+            if(!filter)
+                return true;
+            // The filter is user code, which may throw anything, but only errorCorrupted may leave parse() (parse adds the line and filename)
+            try
+            {
+                return filter(name);
+            }
+            catch(...)
+            {
+                throw errorCorrupted(lineData, 0, errorCorrupted::typeFilter);
+            }
+        }
+
+        unsigned long long iniFile::countContents(ioStats& stats) const
+        {
+            // A section takes "[name]\n" and an empty line, a value "name=value\n"
+            unsigned long long characters=0;
+            stats.sections=sections.size()-tombstoneCount;
+            stats.values=0;
+            stats.valueAllocations=0;
+            for(const_iterator section=begin(); section!=end(); ++section)
+            {
+                characters+=section->nameLength()+4;
+                for(iniSection::const_iterator value=section->begin(); value!=section->end(); ++value)
+                {
+                    characters+=value->nameLength()+value->valueLength()+2;
+                    stats.values++;
+                    if(!value->isStoredInline())
+                        stats.valueAllocations++;
+                }
+            }
+            return characters;
+        }
+
+        void iniFile::report(ioStats* stats, const std::chrono::steady_clock::time_point& start, const bool& succeeded) const
+        {
+            if(!stats)
+                return;
+            // A file that's loaded is counted here, so the sections and values which were loaded before an error occurred are counted as well
+            if(stats->operation==ioStats::opLoad)
+                countContents(*stats);
+            stats->succeeded=succeeded;
+            stats->totalTime=std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-start).count();
+            // This is called from functions which may only throw fileError and errorCorrupted (and while one of them is being thrown),
+            // so whatever the hook throws is dropped, a failing hook shouldn't make loading or saving fail anyway
+            try
+            {
+                statsHook(*stats);
+            }
+            catch(...)
+            {
+            }
+        }
 
-            // String to temporaly store the current line of data
+        iniSection& iniFile::appendSection(const iniSection& section)
+        {
+            // Add the section to the end of the list (using the case sensitivity of this file), store the hash of its name and insert it in the index
+            sections.push_back(section);
+            sections.back().setCaseSensitive(caseSensitive);
+            if(counter)
+                sections.back().startCounting(counter);
+            nameHashes.push_back(diniPrivate::hashName(section.nameData(), section.nameLength()));
+            if(!tombstones.empty())
+                tombstones.push_back(false);
+            diniPrivate::filterAdded(nameFilter, nameHashes);
+            diniPrivate::indexInsert(nameIndex, sections, sections.size()-1, caseSensitive);
+            return sections.back();
+        }
+
+        void iniFile::countNewSections()
+        {
+            if(!counter)
+                return;
+            for(std::vector<iniSection>::iterator section=sections.begin(); section!=sections.end(); ++section)
+            {
+                if(section->counter!=counter)
+                    section->startCounting(counter);
+            }
+        }
+
+        void iniFile::removeErased(const std::vector<bool>& erased)
+        {
+            // Copy the erased marks first, as they may be the tombstones themselves
+            const std::vector<bool> marks(erased);
+            diniPrivate::compactItems(sections, nameHashes, marks, 0);
+            diniPrivate::filterRebuild(nameFilter, nameHashes);
+            diniPrivate::indexCompact(nameIndex, marks);
+            tombstones.clear();
+            tombstoneCount=0;
+        }
+
+        const std::vector<bool>* iniFile::erasedMarks() const
+        { return tombstoneCount!=0 ? &tombstones : 0; }
+        size_t iniFile::position(const iterator& pos)
+        { return pos-iterator(sections.empty() ? 0 : &sections[0], 0, sections.size(), 0); }
+
+        size_t iniFile::findSection(const char* name, const size_t& length) const
+        { return findSection(name, length, diniPrivate::hashName(name, length)); }
+
+        size_t iniFile::findSection(const char* name, const size_t& length, const unsigned int& hash) const
+        {
+            // Names which aren't in the filter certainly don't exist
+            // For the others, scan the (compact) array of hashes, and only compare the actual name when the hash matches
+            // Sections which are marked as erased are skipped
+            if(!diniPrivate::filterMayContain(nameFilter, hash))
+                return sections.size();
+            const unsigned int* hashes=nameHashes.empty() ? 0 : &nameHashes[0];
+            for(size_t pos=0; pos<nameHashes.size(); pos++)
+            {
+                if(hashes[pos]==hash && diniPrivate::sameName(sections[pos].nameData(), sections[pos].nameLength(), name, length, caseSensitive) &&
+                   (tombstones.empty() || !tombstones[pos]))
+                    return pos;
+            }
+            return sections.size();
+        }
+
+        void iniFile::parse(const std::string& data, const std::string& filename, const std::vector<std::string>& includeChain, std::vector<includeStamp>& included,
+                            const sectionFilter& filter, ioStats* stats) throw(fileError, errorCorrupted)
+        {
+            // String to temporaly store the current line of data, and the line number in case an error has to be thrown
             std::string lineData;
-            // Keep track of the line number in case an error has to be thrown
-            // and read all of the lines in the file
-            for(unsigned int line=1; std::getline(file, lineData); line++)
+            unsigned int line=0;
+            // Whether the lines belong to a section that's left out by the filter
+            bool skipping=false;
+            const char* end=data.data()+data.size();
+            const char* lineEnd=0;
+
+            // First look for include directives, and start loading all included files in the background
+            // This way they're loaded at the same time, and are (mostly) ready when they're needed below
+            std::map<std::string, includeCache::future> includes;
+            for(const char* pos=data.data(); pos!=end; pos=(lineEnd==end ? end : lineEnd+1))
             {
-                // If something is wrong, close the file and throw an error
-                if(!file.good())
+                lineEnd=static_cast<const char*>(std::memchr(pos, '\n', end-pos));
+                if(lineEnd==0)
+                    lineEnd=end;
+                const char* first=pos;
+                while(first!=lineEnd && std::isspace(static_cast<unsigned char>(*first)))
+                    first++;
+                std::string path;
+                if(first!=lineEnd && *first=='@' && diniPrivate::includeFromLine(removeWhitespacesAndComments(std::string(first, lineEnd)), path))
                 {
-                    file.close();
-                    throw fileError(filename, fileError::readError);
+                    // Files which are already being included are left out, which is reported when the directive is parsed below
+                    const std::string resolved=diniPrivate::includePath(filename, path);
+                    if(std::find(includeChain.begin(), includeChain.end(), resolved)==includeChain.end() && includes.find(resolved)==includes.end())
+                        includes[resolved]=includeCache::start(resolved, includeChain);
                 }
+            }
+
+            // Go through all of the lines in the file
+            for(const char* pos=data.data(); pos!=end; pos=(lineEnd==end ? end : lineEnd+1))
+            {
+                lineEnd=static_cast<const char*>(std::memchr(pos, '\n', end-pos));
+                if(lineEnd==0)
+                    lineEnd=end;
+                line++;
+                if(stats)
+                    stats->lines=line;
+                // The lines of a section that's left out are skipped, only a section or include directive can end that section
+                if(skipping)
+                {
+                    const char* first=pos;
+                    while(first!=lineEnd && std::isspace(static_cast<unsigned char>(*first)))
+                        first++;
+                    if(first==lineEnd || (*first!='[' && *first!='@'))
+                        continue;
+                }
+                lineData.assign(pos, lineEnd);
                 // Remove any whitespaces and comments from the current line of data
                 // If there isn't any data left after removing the whitespaces and comments,
                 // we won't need to try to extract data from it
-                if((lineData=removeWhitespacesAndComments(lineData))!="")
+                {
+                    diniPrivate::phaseTimer timer(stats ? &stats->tokenizeTime : 0);
+                    lineData=removeWhitespacesAndComments(lineData);
+                }
+                if(lineData!="")
                 {
                     try
                     {
                         // If it's start of a new section, create a new section
+                        // If it's an include directive, add all sections of the included file
                         // If not, it has to be a value, so read the value and store it in the current section
                         // But if there isn't a section opened yet, something's wrong and we throw an error
                         if(lineData[0]=='[')
-                            sections.push_back(sectionFromLine(lineData));
+                        {
+                            diniPrivate::phaseTimer timer(stats ? &stats->valueTime : 0);
+                            iniSection section=sectionFromLine(lineData);
+                            skipping=!keepSection(filter, section.name(), lineData);
+                            if(!skipping)
+                            {
+                                sections.push_back(section);
+                                sections.back().setCaseSensitive(caseSensitive);
+                                nameHashes.push_back(diniPrivate::hashName(sections.back().nameData(), sections.back().nameLength()));
+                            }
+                        }
+                        else if(lineData[0]=='@')
+                        {
+                            // The included file may not be one of the files that are including this file (that would never end)
+                            std::string path;
+                            if(!diniPrivate::includeFromLine(lineData, path))
+                                throw errorCorrupted(lineData, line, errorCorrupted::typeInclude);
+                            const std::string resolved=diniPrivate::includePath(filename, path);
+                            if(std::find(includeChain.begin(), includeChain.end(), resolved)!=includeChain.end())
+                                throw errorCorrupted(lineData, line, errorCorrupted::typeInclude);
+
+                            // Wait for the included file (which rethrows any error that occurred while loading it)
+                            // A file from the cache may include one of the files that are including this file as well
+                            const std::shared_ptr<const includeCache::entry> fragment=includes[resolved].get();
+                            for(std::vector<includeStamp>::const_iterator file=fragment->files.begin(); file!=fragment->files.end(); ++file)
+                            {
+                                if(std::find(includeChain.begin(), includeChain.end(), file->filename)!=includeChain.end())
+                                    throw errorCorrupted(lineData, line, errorCorrupted::typeInclude);
+                            }
+                            included.insert(included.end(), fragment->files.begin(), fragment->files.end());
+                            for(const_iterator section=fragment->file.begin(); section!=fragment->file.end(); ++section)
+                            {
+                                // The values after the directive belong to the last section of the included file, so they're skipped when that one is
+                                skipping=!keepSection(filter, section->name(), lineData);
+                                if(skipping)
+                                    continue;
+                                sections.push_back(*section);
+                                sections.back().setCaseSensitive(caseSensitive);
+                                nameHashes.push_back(diniPrivate::hashName(section->nameData(), section->nameLength()));
+                                // The included file is shared with other files (through the cache), so it was loaded without inferring types
+                                if(typeInference)
+                                {
+                                    for(std::vector<iniValue>::iterator value=sections.back().values.begin(); value!=sections.back().values.end(); ++value)
+                                        value->inferType();
+                                }
+                            }
+                        }
                         else if(sections.size() != 0)
-                            sections.back().addValue(valueFromLine(lineData));
+                        {
+                            diniPrivate::phaseTimer timer(stats ? &stats->valueTime : 0);
+                            iniValue value=valueFromLine(lineData, stats ? &stats->escapes : 0);
+                            if(typeInference)
+                                value.inferType();
+                            sections.back().addValue(value);
+                        }
                         else
                             throw errorCorrupted(lineData, line, errorCorrupted::typeNoSection);
                     }
                     catch(errorCorrupted& err)
                     {
-                        // Close the file, give some more info about the error (which line), and then rethrow the error
-                        file.close();
-                        err.line=line;
+                        // Give some more info about the error (which file and line, unless it occurred in an included file), and then rethrow the error
+                        // The sections read so far are kept, so make sure the index and filter are up to date
+                        diniPrivate::filterRebuild(nameFilter, nameHashes);
+                        diniPrivate::indexRebuild(nameIndex, sections, caseSensitive);
+                        countNewSections();
+                        if(err.filename.empty())
+                        {
+                            err.line=line;
+                            err.filename=filename;
+                        }
                         throw err;
                     }
+                    catch(fileError&)
+                    {
+                        // An included file couldn't be read, which is reported at the directive (the path is in the line)
+                        diniPrivate::filterRebuild(nameFilter, nameHashes);
+                        diniPrivate::indexRebuild(nameIndex, sections, caseSensitive);
+                        countNewSections();
+                        throw errorCorrupted(lineData, line, errorCorrupted::typeInclude, filename);
+                    }
                 }
             }
-            file.close();
+
+            // The sections have been added without updating the index and filter, so build them in one go now
+            diniPrivate::filterRebuild(nameFilter, nameHashes);
+            diniPrivate::indexRebuild(nameIndex, sections, caseSensitive);
+            countNewSections();
         }
 
-    // Private:
         std::string iniFile::removeWhitespacesAndComments(const std::string& line) const
         {
             // String to return
@@ -276,7 +1364,7 @@ namespace dini
             return iniSection(line.substr(start+1, end-start-1));
         }
 
-        iniValue iniFile::valueFromLine(const std::string& line) const throw(errorCorrupted)
+        iniValue iniFile::valueFromLine(const std::string& line, unsigned long long* escapes) const throw(errorCorrupted)
         {
             // We're going to return 'out', buffer is to temporary store a part of the line, and nameDone is true if the '=' is found
             iniValue out;
@@ -313,6 +1401,8 @@ namespace dini
                     {
                         if((++pos)==line.end())
                             throw errorCorrupted(line, -1, errorCorrupted::typeValue);
+                        if(escapes)
+                            ++*escapes;
                         switch(*pos)
                         {
                             case '0':   buffer+='\0';   break;
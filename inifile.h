@@ -14,8 +14,13 @@
 ************************************************************************************************************/
 
 #include "inisection.h"
+#include "inibatch.h"
+#include "inistats.h"
 #include <string>
 #include <vector>
+#include <future>
+#include <functional>
+#include <chrono>
 
 namespace dini
 {
@@ -45,30 +50,105 @@ namespace dini
             {
                 typeSection,        // While parsing a section name
                 typeValue,          // While parsing a value
-                typeNoSection       // When a value was found while there isn't a section found yet
+                typeNoSection,      // When a value was found while there isn't a section found yet
+                typeInclude,        // While parsing an include directive (or when the included file can't be read, or a file includes itself, directly or indirectly)
+                typeFilter          // When the section filter threw an exception for the section on this line
             };
 
-            errorCorrupted(const std::string& lineData, const unsigned int& line, const corruptionType& type);
+            errorCorrupted(const std::string& lineData, const unsigned int& line, const corruptionType& type, const std::string& filename="");
 
             std::string lineData;   // The raw data on the line where the error occurred
             unsigned int line;      // On which line the error occurred
             corruptionType type;    // When the corruption was found
+            std::string filename;   // The file the error occurred in, which is the included file when the error is in an included file
     };
 
+    // Error class, thrown when the references in a value can't be expanded (see iniFile::getExpanded())
+    class interpolationError
+    {
+        public:
+            enum errorType              // What's wrong with the reference
+            {
+                unknownReference,       // The section or value it refers to doesn't exist
+                cyclicReference,        // The value it refers to (indirectly) refers back to itself
+                badReference            // It isn't of the form ${section:name}
+            };
+
+            interpolationError(const std::string& reference, const errorType& type);
+
+            std::string reference;      // The reference that couldn't be expanded (the part between the braces)
+            errorType type;             // What's wrong with the reference
+    };
+
+    // Executor used by the asynchronous functions of iniFile
+    // It's given a task, which it has to run at some point (for example on a thread pool or the worker thread of an event loop)
+    typedef std::function<void(std::function<void()>)> executor;
+
+    // Filter for loading only some of the sections of a file, given the name of a section it returns whether to load that section
+    typedef std::function<bool(const std::string&)> sectionFilter;
+
+    class iniSnapshot;
+
     // Class which represents a whole ini file
     // An ini file exists out of sections, which each exist out of values
     class iniFile
     {
         public:
-            // Iterators
-            typedef std::vector<iniSection>::iterator iterator;
-            typedef std::vector<iniSection>::reverse_iterator reverse_iterator;
-            typedef std::vector<iniSection>::const_iterator const_iterator;
-            typedef std::vector<iniSection>::const_reverse_iterator const_reverse_iterator;
+            // Iterators (the const iterators skip the sections marked as erased, see setEraseLimit())
+            typedef liveIterator<iniSection> iterator;
+            typedef std::reverse_iterator<iterator> reverse_iterator;
+            typedef liveIterator<const iniSection> const_iterator;
+            typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+            // Ranges, as returned by findPrefix() and findMatching()
+            typedef nameRange<iniSection> range;
+            typedef nameRange<const iniSection> const_range;
+
+            // Creates an empty file
+            iniFile();
+
+            // Whether the names of sections and values are case sensitive (which is the default)
+            // When they're not, "Section", "section" and "SECTION" all refer to the same section (and the same goes for the values in it),
+            // but every name keeps the spelling it was added with, so the file is saved with the original spelling
+            // The hashes of the names ignore case anyway, so lookups don't have to copy or convert any names in either mode
+            bool isCaseSensitive() const;
+            void setCaseSensitive(const bool& caseSensitive);
+
+            // Whether the types of the values are inferred while loading a file (which is off by default)
+            // When it's on, every value that's loaded is checked once for an int, double or bool (see iniValue::inferType()),
+            // so reading it as that type later doesn't have to parse it again, which makes loading a bit slower but reading files full of numbers a lot faster
+            // Turning it on also infers the types of the values which are already in the file
+            bool infersTypes() const;
+            void setInferTypes(const bool& inferTypes);
+
+            // Whether lookups are counted, to find the hottest keys and the keys which are never read (which is off by default)
+            // While it's on, each lookup that finds a section (getSection(), tryGetSection(), sectionExists() and operator[]) or a value (the same functions of iniSection)
+            // adds one to its counter. Setting values with setValue() or setSection() isn't counted, but writing through getValue() or operator[] is,
+            // as those can't tell reading from writing. The counters are atomic and spread over a few shards (see iniaccess.h),
+            // so threads reading the same file don't wait for each other, and copies of this file or its sections count in the same counters
+            // When it's off, a lookup only checks a null pointer, and when it's on, every section and value takes two size_t's more (which are freed when it's turned off)
+            // Turning it on starts counting at 0, and so does loading a file
+            bool countsAccesses() const;
+            void setAccessCounting(const bool& countAccesses);
+            // Get the number of lookups of every section (with an empty value name) and value, from the most to the least looked up
+            std::vector<accessCount> accessCounts() const;
+            // Get the count values which were looked up the most, from the most looked up down
+            std::vector<accessCount> hottestKeys(const size_t& count) const;
+            // Get all values which haven't been looked up since counting started, in the order of the file
+            std::vector<accessCount> unreadKeys() const;
+            // Set all counters back to 0
+            void resetAccessCounts();
 
             // Get a section by name
             iniSection& getSection(const std::string& name);
             iniSection getSection(const std::string& name) const throw(unknownName);
+            // Get a section by name without creating or throwing, returns a null pointer if the section doesn't exist
+            iniSection* tryGetSection(const std::string& name);
+            const iniSection* tryGetSection(const std::string& name) const;
+            // The same, using a key with a precomputed hash (see inikey.h)
+            iniSection& getSection(const iniKey& key);
+            iniSection getSection(const iniKey& key) const throw(unknownName);
+            iniSection* tryGetSection(const iniKey& key);
+            const iniSection* tryGetSection(const iniKey& key) const;
             // Change the contents of an entire section
             void setSection(const std::string& name, const iniSection& section);
             // Rename a section (the new name may not already exist), returns true if the renaming was succesfull
@@ -79,14 +159,88 @@ namespace dini
             void erase(const iterator& pos);
             // Erase a range of values, from first (included) to last (excluded)
             void erase(const iterator& first, const iterator& last);
+            // Erase all sections for which predicate(section) returns true (it's given a const iniSection&), returns the number of erased sections
+            // All sections are checked first, and then removed in one pass, so this is much faster than erasing them one by one
+            template<class Predicate> size_t eraseIf(Predicate predicate)
+            {
+                // Sections which are already marked as erased (see setEraseLimit()) are removed in the same pass
+                std::vector<bool> erased(tombstones.empty() ? std::vector<bool>(sections.size(), false) : tombstones);
+                size_t count=0;
+                for(size_t pos=0; pos<sections.size(); pos++)
+                {
+                    if(!erased[pos] && predicate(static_cast<const iniSection&>(sections[pos])))
+                    {
+                        erased[pos]=true;
+                        count++;
+                    }
+                }
+                if(count!=0 || tombstoneCount!=0)
+                    removeErased(erased);
+                return count;
+            }
+            // Deferred erasing of sections, which is off (0) by default, see iniSection::setEraseLimit()
+            // Marked sections are removed when more than limit sections are marked, or as soon as the sections of a non-const file are used by position
+            // (by the iterators, findPrefix(), findMatching(), apply() or compact()), the const functions skip them instead
+            void setEraseLimit(const size_t& limit);
+            size_t eraseLimit() const;
+            // Remove all sections which are marked as erased
+            void compact();
+            // Get how much memory this file uses, for each section and for the file itself (see inistats.h)
+            memoryReport memoryUsage() const;
+            // Release all memory that isn't used by this file and its sections (see iniSection::shrinkToFit())
+            void shrinkToFit();
             // Check whether a section exists
             bool sectionExists(const std::string& name) const;
+            // Get all sections whose name starts with prefix, ordered by name
+            range findPrefix(const std::string& prefix);
+            const_range findPrefix(const std::string& prefix) const;
+            // Get all sections whose name matches the glob pattern (where '*' matches anything and '?' matches any single character), ordered by name
+            // Only the sections starting with the part of the pattern before the first wildcard are checked, so patterns like "shard_*" are fast
+            range findMatching(const std::string& pattern);
+            const_range findMatching(const std::string& pattern) const;
+            // Note: these queries use an index which is kept up to date by this class,
+            // so rename sections using rename() instead of calling setName() on a section in this file
+            // Get the value with the given name from every section at once, converted to a double or int, in the order of the sections
+            // The result is stored in out (one number per section), sections without the value or with a value that can't be converted get defaultValue
+            // Returns the number of sections for which the value was found and converted succesfully
+            size_t getColumn(const std::string& name, std::vector<double>& out, const double& defaultValue=0) const;
+            size_t getColumn(const std::string& name, std::vector<int>& out, const int& defaultValue=0) const;
+            // The same, but only for the given sections (for example the result of findMatching()), in the order of that range
+            size_t getColumn(const const_range& selection, const std::string& name, std::vector<double>& out, const double& defaultValue=0) const;
+            size_t getColumn(const const_range& selection, const std::string& name, std::vector<int>& out, const int& defaultValue=0) const;
             // Clear the whole file (remove all sections)
             void clear();
 
+            // Get a 64 bit hash of the names and fingerprints of all sections (see iniSection::fingerprint()), in their order
+            // Each section keeps its own fingerprint up to date (see iniSection::fingerprint()), so this takes one step per section for most sections
+            // So comparing the fingerprints of two files is a cheap way to check whether for example a reloaded file differs from the one in use
+            unsigned long long fingerprint() const;
+            // Get the names of the sections which differ between this file and other: the sections with a different fingerprint,
+            // the sections which are only in this file, and then the sections which are only in the other file (each file matches names its own way, see setCaseSensitive())
+            std::vector<std::string> changedSections(const iniFile& other) const;
+
+            // Apply all changes in the batch at once, in the order they were added to the batch
+            // All names are checked first: if any of them isn't valid, nothing is changed and false is returned
+            // A section that is erased and then created again in the same batch keeps its place in the file
+            // Like any other change, this isn't thread safe, but it means that other threads only have to be locked out once for the whole batch
+            bool apply(const iniBatch& batch);
+
+            // Get a value with every reference of the form ${section:name} in it replaced by the value it refers to,
+            // which is expanded the same way first (use $$ to get a single $)
+            // Throws unknownName if the value itself doesn't exist, and interpolationError if one of the references can't be expanded
+            // The expanded values are cached, together with the (raw) values they were made from,
+            // so a value is only expanded again when the value itself, or one of the values it refers to (directly or indirectly), has changed
+            std::string getExpanded(const std::string& section, const std::string& name) const throw(unknownName, interpolationError);
+
+            // Make an immutable copy of this file, which is faster to read from (see inisnapshot.h)
+            // Use this for files which won't be changed anymore after loading them
+            iniSnapshot freeze() const;
+
             // Get section by name
             iniSection& operator[](const std::string& name);
             iniSection operator[](const std::string& name) const;
+            iniSection& operator[](const iniKey& key);
+            iniSection operator[](const iniKey& key) const;
 
             // Get iterator to the beginning of the list of sections
             iterator begin();
@@ -105,14 +259,105 @@ namespace dini
             // Save all data to a ini file
             void saveToFile(const std::string& filename) const throw(fileError);
             // Load all data from a ini file
+            // A line of the form "@include path" is replaced by the sections of the ini file at path (relative to the directory of the file it's in),
+            // which has to start with a section itself. All files included by a file are loaded in parallel (on at most one thread per core for all files together),
+            // and each included file is only parsed once per process (as long as it, and the files it includes, don't change, and it's still in the cache,
+            // see setIncludeCacheLimit()), so files included by many other files are cheap to include
             void loadFromFile(const std::string& filename) throw(fileError, errorCorrupted);
+            // Load only the sections of a ini file for which filter returns true, or only the sections with the given names
+            // The lines of the other sections are skipped without storing or even decoding them (only the start of each line is checked,
+            // to find the next section), so this is a lot faster and takes a lot less memory when only a few sections of a big file are needed
+            // Note that this means that errors in those lines aren't found either. Sections from included files are filtered the same way
+            // When filter throws, loading stops with an errorCorrupted of type typeFilter for the line of that section
+            void loadFromFile(const std::string& filename, const sectionFilter& filter) throw(fileError, errorCorrupted);
+            void loadFromFile(const std::string& filename, const std::vector<std::string>& sectionNames) throw(fileError, errorCorrupted);
+            // Forget all included files parsed so far (they're parsed again when they're included the next time)
+            static void clearIncludeCache();
+            // Set how many included files are kept parsed (256 by default), when there are more the ones used longest ago are forgotten
+            static void setIncludeCacheLimit(const size_t& files);
+            // Set a hook which is called with statistics (see inistats.h) each time this file is loaded or saved, an empty function removes it
+            // Nothing is measured while there's no hook, so it doesn't slow down loading or saving then
+            // Anything the hook throws is ignored, so it doesn't make loading or saving fail
+            void setInstrumentation(const instrumentation& hook);
+
+            // Load an ini file in the background, on a new thread or using the given executor
+            // The future gives the loaded file, or rethrows the fileError or errorCorrupted thrown while loading
+            static std::future<iniFile> loadFromFileAsync(const std::string& filename);
+            static std::future<iniFile> loadFromFileAsync(const std::string& filename, const executor& exec);
+            // Save all data to a ini file in the background, on a new thread or using the given executor
+            // The future is ready when the file is saved, or rethrows the fileError thrown while saving
+            // Note that this object isn't copied, so it has to stay alive and unchanged until the future is ready
+            std::future<void> saveToFileAsync(const std::string& filename) const;
+            std::future<void> saveToFileAsync(const std::string& filename, const executor& exec) const;
 
         private:
+            friend class iniConcurrentFile;
+
+            class expansionCache;
+            // Owns the cache of expanded values, a copy of a file starts with an empty cache
+            class expansionCacheHolder
+            {
+                public:
+                    expansionCacheHolder();
+                    expansionCacheHolder(const expansionCacheHolder& other);
+                    ~expansionCacheHolder();
+                    expansionCacheHolder& operator=(const expansionCacheHolder& other);
+
+                    expansionCache* cache;
+            };
+
+            // The included files parsed so far by this process
+            class includeCache;
+            // The state of a file when it was read, to check whether it has changed since
+            struct includeStamp
+            {
+                std::string filename;
+                unsigned long long modified;
+                unsigned long long size;
+            };
+
+            iniSection& appendSection(const iniSection& section);
+            // Start counting the lookups of the sections which aren't counted yet (when access counting is on)
+            void countNewSections();
+            // Remove the sections marked in erased in one pass (and forget all tombstones)
+            void removeErased(const std::vector<bool>& erased);
+            // The marks of the sections which are erased, or a null pointer when there aren't any (for the const iterators and ranges)
+            const std::vector<bool>* erasedMarks() const;
+            // The index in sections of the section pos points to (pos is a non-const iterator, so nothing is marked)
+            size_t position(const iterator& pos);
+            // Parse the contents (data) of the file filename and add its sections, includeChain holds the files that are being included (to find cycles)
+            // The stamps of all files included by this file (directly or indirectly) are added to included
+            // Only the sections for which filter returns true are added (all of them when it's empty)
+            // When stats isn't a null pointer, what's done is counted and timed in it
+            void parse(const std::string& data, const std::string& filename, const std::vector<std::string>& includeChain, std::vector<includeStamp>& included,
+                       const sectionFilter& filter, ioStats* stats) throw(fileError, errorCorrupted);
+            // Whether filter keeps the section with the given name (found on lineData), anything thrown by filter is turned into an errorCorrupted
+            bool keepSection(const sectionFilter& filter, const std::string& name, const std::string& lineData) const throw(errorCorrupted);
+            // Count the sections and values in stats, returns the number of characters they take in a file (without escaping anything)
+            unsigned long long countContents(ioStats& stats) const;
+            // Pass stats to the instrumentation hook (if stats isn't a null pointer), start is when loading or saving started
+            void report(ioStats* stats, const std::chrono::steady_clock::time_point& start, const bool& succeeded) const;
+            // Get the position of the section with the given name, returns sections.size() if there is no such section
+            size_t findSection(const char* name, const size_t& length) const;
+            size_t findSection(const char* name, const size_t& length, const unsigned int& hash) const;
             std::string removeWhitespacesAndComments(const std::string& line) const;
             iniSection sectionFromLine(const std::string& line) const throw(errorCorrupted);
-            iniValue valueFromLine(const std::string& line) const throw(errorCorrupted);
+            // The number of escape sequences in the value is added to escapes, if it isn't a null pointer
+            iniValue valueFromLine(const std::string& line, unsigned long long* escapes) const throw(errorCorrupted);
 
             std::vector<iniSection> sections;
+            std::vector<unsigned int> nameHashes;           // Hashes of the names of the sections, in the same order as sections
+            std::vector<unsigned long long> nameFilter;     // Bloom filter over nameHashes, to quickly skip sections that don't exist
+            std::vector<size_t> nameIndex;                  // Positions in sections, sorted by the name of the section
+            bool caseSensitive;
+            bool typeInference;
+            // Deferred erasing, tombstones marks the sections which are erased (it's empty when there aren't any)
+            std::vector<bool> tombstones;
+            size_t tombstoneCount;
+            size_t tombstoneLimit;
+            expansionCacheHolder expansions;
+            instrumentation statsHook;
+            std::shared_ptr<accessCounter> counter;         // The counters of the sections and values, a null pointer when access counting is off
     };
 }
 
@@ -0,0 +1,86 @@
+#ifndef INIKEY_H
+#define INIKEY_H
+
+
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* This code is under the GPLv3 license.                                                                     *
+* That means that you're free to use and edit this code,                                                    *
+* as long as you publish any changes you make using this license.                                           *
+*                                                                                                           *
+* For the full license, see gpl3.txt or gpl3.html.                                                          *
+************************************************************************************************************/
+
+#include <string>
+#include <cstddef>
+
+namespace dini
+{
+    // Error class, thrown when a key is created from an invalid name
+    // Keys created with the _key literal are normally checked at compile time, so this is only thrown when one is created at runtime
+    class invalidKey
+    {
+        public:
+            invalidKey(const std::string& name)
+                :name(name){}
+
+            std::string name;   // The invalid name
+    };
+
+    // A name of a section or value, together with its hash, which can be computed at compile time
+    // Create keys with the _key literal, for example ini["cache"_key]["ttl"_key]
+    // When the key is a constexpr variable, the name is checked and hashed by the compiler, so the lookup doesn't have to process the name at all:
+    //     constexpr dini::iniKey ttl="ttl"_key;
+    // In other expressions the compiler will usually do the same, but that's up to the compiler
+    class iniKey
+    {
+        public:
+            // Creates a key from the first length characters of name, which has to stay valid as long as the key is used (like a string literal)
+            // Throws invalidKey if the name isn't valid (that is, at compile time the compilation fails)
+            constexpr iniKey(const char* name, const size_t& length)
+                :name(name), length(length), keyHash(valid(name, length, true) ? hash(name, length, 2166136261u) : throw invalidKey(std::string(name, length))){}
+
+            // Get the name of the key
+            std::string toString() const
+            { return std::string(name, length); }
+            // Direct access to the name
+            constexpr const char* nameData() const
+            { return name; }
+            constexpr size_t nameLength() const
+            { return length; }
+            // Get the hash of the name, which is the same as the hash used by iniFile and iniSection for their names
+            constexpr unsigned int nameHash() const
+            { return keyHash; }
+
+        private:
+            // The same rules as diniPrivate::validName()
+            static constexpr bool valid(const char* name, const size_t& length, const bool& first)
+            {
+                return length==0 ? !first :
+                       ((*name=='_' || (*name>='a' && *name<='z') || (*name>='A' && *name<='Z') || (!first && *name>='0' && *name<='9')) &&
+                        valid(name+1, length-1, false));
+            }
+            // The same as diniPrivate::hashName() (32 bit FNV-1a, ignoring case)
+            static constexpr unsigned int hash(const char* name, const size_t& length, const unsigned int& current)
+            {
+                return length==0 ? current :
+                       hash(name+1, length-1, (current^static_cast<unsigned char>((*name>='A' && *name<='Z') ? *name-'A'+'a' : *name))*16777619u);
+            }
+
+            const char* name;
+            size_t length;
+            unsigned int keyHash;
+    };
+
+    inline namespace literals
+    {
+        // Creates an iniKey, for example "ttl"_key
+        constexpr iniKey operator"" _key(const char* name, size_t length)
+        { return iniKey(name, length); }
+    }
+}
+
+#endif // INIKEY_H
@@ -8,15 +8,54 @@ namespace dini
         unknownName::unknownName(const std::string& name)
             :name(name){}
 
+// iniSection::fingerprintCache
+    // Public:
+        iniSection::fingerprintCache::fingerprintCache()
+            :hash(0), exposed(false){}
+        iniSection::fingerprintCache::fingerprintCache(const fingerprintCache& other)
+            :hash(other.hash.load(std::memory_order_relaxed)), exposed(false){}
+        iniSection::fingerprintCache& iniSection::fingerprintCache::operator=(const fingerprintCache& other)
+        {
+            hash.store(other.hash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            exposed=false;
+            return *this;
+        }
+
 // iniSection
     // Public:
         iniSection::iniSection(const std::string& name)
-            :sectionName(diniPrivate::validName(name)?name:"section"){}
+            :sectionName(diniPrivate::validName(name)?name:"section"), caseSensitive(true), tombstoneCount(0), tombstoneLimit(0), sectionSlot(0){}
         iniSection::iniSection(const std::string& name, const iniSection& other)
-            :sectionName(diniPrivate::validName(name)?name:"section"), values(other.values){}
+            :sectionName(diniPrivate::validName(name)?name:"section"), values(other.values), nameHashes(other.nameHashes), nameFilter(other.nameFilter), nameIndex(other.nameIndex), caseSensitive(other.caseSensitive),
+             tombstones(other.tombstones), tombstoneCount(other.tombstoneCount), tombstoneLimit(other.tombstoneLimit), sectionSlot(0),
+             contentHash(other.contentHash){}
+        iniSection::iniSection(const iniSection& other)
+            :sectionName(other.sectionName), values(other.values), nameHashes(other.nameHashes), nameFilter(other.nameFilter), nameIndex(other.nameIndex), caseSensitive(other.caseSensitive),
+             tombstones(other.tombstones), tombstoneCount(other.tombstoneCount), tombstoneLimit(other.tombstoneLimit), counter(other.counter), counterSlots(other.counterSlots),
+             sectionSlot(other.sectionSlot), contentHash(other.contentHash)
+        {
+            if(counter)
+            {
+                counter->retain(sectionSlot);
+                counter->retain(counterSlots);
+            }
+        }
+
+        iniSection::~iniSection()
+        {
+            if(counter)
+            {
+                counter->release(sectionSlot);
+                counter->release(counterSlots);
+            }
+        }
 
         std::string iniSection::name() const
         { return sectionName; }
+        const char* iniSection::nameData() const
+        { return sectionName.data(); }
+        size_t iniSection::nameLength() const
+        { return sectionName.length(); }
 
         bool iniSection::setName(const std::string& name)
         {
@@ -30,202 +69,564 @@ namespace dini
         }
 
         void iniSection::clear()
-        { values.clear(); }
+        {
+            values.clear();
+            nameHashes.clear();
+            nameFilter.clear();
+            nameIndex.clear();
+            tombstones.clear();
+            tombstoneCount=0;
+            if(counter)
+                counter->release(counterSlots);
+            counterSlots.clear();
+            // The values that were handed out are gone
+            contentHash=fingerprintCache();
+        }
+
+        bool iniSection::isCaseSensitive() const
+        { return caseSensitive; }
+        void iniSection::setCaseSensitive(const bool& caseSensitive)
+        {
+            // The hashes already ignore case, only the order of the index depends on this setting
+            if(this->caseSensitive==caseSensitive)
+                return;
+            this->caseSensitive=caseSensitive;
+            diniPrivate::indexRebuild(nameIndex, values, caseSensitive);
+        }
 
         iniValue& iniSection::getValue(const std::string& name)
         {
             // Search for the value by name, if it's found, return it.
             // If it isn't found, create it and return the new value
-            for(std::vector<iniValue>::iterator pos=values.begin(); pos!=values.end(); pos++)
-            {
-                if(name==pos->name())
-                    return *pos;
-            }
-            values.push_back(iniValue(name));
-            return values.back();
+            if(iniValue* value=tryGetValue(name))
+                return *value;
+            return appendValue(iniValue(name));
         }
 
         iniValue iniSection::getValue(const std::string& name) const throw(unknownName)
         {
             // Search for the value by name, if it's found, return it.
             // If not, throw an error
-            for(std::vector<iniValue>::const_iterator pos=values.begin(); pos!=values.end(); pos++)
-            {
-                if(name==pos->name())
-                    return *pos;
-            }
+            if(const iniValue* value=tryGetValue(name))
+                return *value;
             throw unknownName(name);
         }
 
-        void iniSection::setValue(const std::string& name, const iniValue& value)
+        iniValue* iniSection::tryGetValue(const std::string& name)
         {
-            // Search for the value by name, if it's found, assign the new value to it, if not, create it and assign the new value to it
-            for(std::vector<iniValue>::iterator pos=values.begin(); pos!=values.end(); pos++)
-            {
-                if(name==pos->name())
-                {
-                    *pos=value;
-                    return;
-                }
-            }
-            values.push_back(iniValue(name, value));
+            // Search for the value by name, if it's found, return a pointer to it, if not, return a null pointer
+            // The value may be changed through the pointer
+            exposeValues();
+            const size_t pos=findValue(name.data(), name.length());
+            if(counter && pos!=values.size())
+                counter->count(counterSlots[pos]);
+            return pos!=values.size() ? &values[pos] : 0;
         }
-        void iniSection::setValue(const std::string& name, const int& value)
+
+        const iniValue* iniSection::tryGetValue(const std::string& name) const
         {
-            // Search for the value by name, if it's found, assign the new value to it, if not, create it and assign the new value to it
-            for(std::vector<iniValue>::iterator pos=values.begin(); pos!=values.end(); pos++)
-            {
-                if(name==pos->name())
-                {
-                    pos->setValue(value);
-                    return;
-                }
-            }
-            values.push_back(iniValue(name, value));
+            // Search for the value by name, if it's found, return a pointer to it, if not, return a null pointer
+            const size_t pos=findValue(name.data(), name.length());
+            if(counter && pos!=values.size())
+                counter->count(counterSlots[pos]);
+            return pos!=values.size() ? &values[pos] : 0;
         }
-        void iniSection::setValue(const std::string& name, const double& value)
+
+        iniValue& iniSection::getValue(const iniKey& key)
         {
-            // Search for the value by name, if it's found, assign the new value to it, if not, create it and assign the new value to it
-            for(std::vector<iniValue>::iterator pos=values.begin(); pos!=values.end(); pos++)
-            {
-                if(name==pos->name())
-                {
-                    pos->setValue(value);
-                    return;
-                }
-            }
-            values.push_back(iniValue(name, value));
+            // Search for the value by its key, if it's found, return it.
+            // If it isn't found, create it and return the new value
+            if(iniValue* value=tryGetValue(key))
+                return *value;
+            return appendValue(iniValue(key.toString()));
         }
-        void iniSection::setValue(const std::string& name, const char& value)
+
+        iniValue iniSection::getValue(const iniKey& key) const throw(unknownName)
         {
-            // Search for the value by name, if it's found, assign the new value to it, if not, create it and assign the new value to it
-            for(std::vector<iniValue>::iterator pos=values.begin(); pos!=values.end(); pos++)
-            {
-                if(name==pos->name())
-                {
-                    pos->setValue(value);
-                    return;
-                }
-            }
-            values.push_back(iniValue(name, value));
+            // Search for the value by its key, if it's found, return it.
+            // If not, throw an error
+            if(const iniValue* value=tryGetValue(key))
+                return *value;
+            throw unknownName(key.toString());
         }
-        void iniSection::setValue(const std::string& name, const bool& value)
+
+        iniValue* iniSection::tryGetValue(const iniKey& key)
         {
-            // Search for the value by name, if it's found, assign the new value to it, if not, create it and assign the new value to it
-            for(std::vector<iniValue>::iterator pos=values.begin(); pos!=values.end(); pos++)
-            {
-                if(name==pos->name())
-                {
-                    pos->setValue(value);
-                    return;
-                }
-            }
-            values.push_back(iniValue(name, value));
+            // The key already has its hash, so the name doesn't have to be hashed again
+            exposeValues();
+            const size_t pos=findValue(key.nameData(), key.nameLength(), key.nameHash());
+            if(counter && pos!=values.size())
+                counter->count(counterSlots[pos]);
+            return pos!=values.size() ? &values[pos] : 0;
         }
-        void iniSection::setValue(const std::string& name, const std::string& value)
+
+        const iniValue* iniSection::tryGetValue(const iniKey& key) const
         {
-            // Search for the value by name, if it's found, assign the new value to it, if not, create it and assign the new value to it
-            for(std::vector<iniValue>::iterator pos=values.begin(); pos!=values.end(); pos++)
-            {
-                if(name==pos->name())
-                {
-                    pos->setValue(value);
-                    return;
-                }
-            }
-            values.push_back(iniValue(name, value));
+            // The key already has its hash, so the name doesn't have to be hashed again
+            const size_t pos=findValue(key.nameData(), key.nameLength(), key.nameHash());
+            if(counter && pos!=values.size())
+                counter->count(counterSlots[pos]);
+            return pos!=values.size() ? &values[pos] : 0;
         }
+
+        void iniSection::setValue(const std::string& name, const iniValue& value)
+        { assignValue(name, value); }
+        void iniSection::setValue(const std::string& name, const int& value)
+        { assignValue(name, value); }
+        void iniSection::setValue(const std::string& name, const double& value)
+        { assignValue(name, value); }
+        void iniSection::setValue(const std::string& name, const char& value)
+        { assignValue(name, value); }
+        void iniSection::setValue(const std::string& name, const bool& value)
+        { assignValue(name, value); }
+        void iniSection::setValue(const std::string& name, const std::string& value)
+        { assignValue(name, value); }
         void iniSection::setValue(const std::string& name, const char* value)
-        {
-            // Search for the value by name, if it's found, assign the new value to it, if not, create it and assign the new value to it
-            for(std::vector<iniValue>::iterator pos=values.begin(); pos!=values.end(); pos++)
-            {
-                if(name==pos->name())
-                {
-                    pos->setValue(value);
-                    return;
-                }
-            }
-            values.push_back(iniValue(name, value));
-        }
+        { assignValue(name, value); }
 
         bool iniSection::addValue(const iniValue& value)
         {
             // Check if the value doesn't already exist, if it doesn't, add it to the list of values and return true, if it doesn't return false
-            if(valueExists(value.name()))
+            if(findValue(value.nameData(), value.nameLength())!=values.size())
                 return false;
-            values.push_back(value);
+            appendValue(value);
             return true;
         }
 
         bool iniSection::rename(const std::string& oldName, const std::string& newName)
         {
-            // If the new name already exists, or the new name isn't valid return false
-            if(valueExists(newName) || !diniPrivate::validName(newName))
+            // If the new name isn't valid, or the value doesn't exist, return false
+            const size_t pos=findValue(oldName.data(), oldName.length());
+            if(pos==values.size() || !diniPrivate::validName(newName))
                 return false;
-            // Search for the value and change it's name, return if succesfull (which will always be because we've allready checked if the name is valid)
-            for(std::vector<iniValue>::iterator pos=values.begin(); pos!=values.end(); pos++)
-            {
-                if(oldName==pos->name())
-                    return pos->setName(newName);
-            }
-            return false;
+            // If the new name already exists return false, unless only the case of this value's name changes
+            const size_t existing=findValue(newName.data(), newName.length());
+            if(existing!=values.size() && (existing!=pos || diniPrivate::sameName(values[pos].nameData(), values[pos].nameLength(), newName.data(), newName.length(), true)))
+                return false;
+            // Change its name, update its hash and move it to its new place in the index
+            updateFingerprint(values[pos], false);
+            values[pos].setName(newName);
+            updateFingerprint(values[pos], true);
+            nameHashes[pos]=diniPrivate::hashName(newName.data(), newName.length());
+            diniPrivate::filterRenamed(nameFilter, nameHashes, pos);
+            diniPrivate::indexRename(nameIndex, values, pos, caseSensitive);
+            return true;
         }
         bool iniSection::erase(const std::string& name)
         {
-            // Search for the section, if we find it we erase it and return true, if not we return false
-            for(std::vector<iniValue>::iterator pos=values.begin(); pos!=values.end(); pos++)
+            // Search for the value, if we find it we erase it and return true, if not we return false
+            const size_t pos=findValue(name.data(), name.length());
+            if(pos==values.size())
+                return false;
+            if(tombstoneLimit==0)
             {
-                if(name==pos->name())
-                {
-                    values.erase(pos);
-                    return true;
-                }
+                erase(iterator(&values[0], pos, values.size(), 0));
+                return true;
             }
-            return false;
+            // With deferred erasing, only mark the value, until there are too many marked values
+            updateFingerprint(values[pos], false);
+            if(tombstones.empty())
+                tombstones.assign(values.size(), false);
+            tombstones[pos]=true;
+            if(++tombstoneCount>tombstoneLimit)
+                compact();
+            return true;
         }
         void iniSection::erase(const iterator& pos)
-        { values.erase(pos); }
+        { erase(pos, pos+1); }
         void iniSection::erase(const iterator& first, const iterator& last)
-        { values.erase(first, last); }
+        {
+            const size_t from=position(first);
+            const size_t to=position(last);
+            for(size_t pos=from; pos<to; ++pos)
+            {
+                if(tombstones.empty() || !tombstones[pos])
+                    updateFingerprint(values[pos], false);
+            }
+            // Values in the range which are already marked as erased don't have to be marked anymore
+            if(!tombstones.empty())
+            {
+                tombstoneCount-=std::count(tombstones.begin()+from, tombstones.begin()+to, true);
+                tombstones.erase(tombstones.begin()+from, tombstones.begin()+to);
+                if(tombstoneCount==0)
+                    tombstones.clear();
+            }
+            if(counter)
+            {
+                counter->release(std::vector<size_t>(counterSlots.begin()+from, counterSlots.begin()+to));
+                counterSlots.erase(counterSlots.begin()+from, counterSlots.begin()+to);
+            }
+            diniPrivate::indexErase(nameIndex, from, to);
+            nameHashes.erase(nameHashes.begin()+from, nameHashes.begin()+to);
+            diniPrivate::filterRebuild(nameFilter, nameHashes);
+            diniPrivate::eraseItems(values, values.begin()+from, values.begin()+to);
+        }
+        void iniSection::setEraseLimit(const size_t& limit)
+        {
+            tombstoneLimit=limit;
+            if(tombstoneCount>tombstoneLimit)
+                compact();
+        }
+        size_t iniSection::eraseLimit() const
+        { return tombstoneLimit; }
+
+        void iniSection::compact()
+        {
+            if(tombstoneCount!=0)
+                removeErased(tombstones);
+        }
+
+        sectionMemory iniSection::memoryUsage() const
+        {
+            sectionMemory result;
+            result.name=sectionName;
+            const size_t nameHeap=diniPrivate::stringHeapSize(sectionName);
+            result.names=nameHeap!=0 ? sectionName.length()+1 : 0;
+            result.slack=nameHeap-result.names;
+            for(std::vector<iniValue>::const_iterator value=values.begin(); value!=values.end(); ++value)
+            {
+                if(value->isStoredInline())
+                    continue;
+                result.names+=value->nameLength();
+                result.values+=value->valueLength();
+                result.slack+=value->heapSize()-value->nameLength()-value->valueLength();
+            }
+            result.objects=diniPrivate::vectorBytes(values);
+            result.lookup=diniPrivate::vectorBytes(nameHashes)+diniPrivate::vectorBytes(nameFilter)+diniPrivate::vectorBytes(nameIndex)+
+                          diniPrivate::vectorBytes(tombstones)+diniPrivate::vectorBytes(counterSlots);
+            result.slack+=diniPrivate::vectorSlack(values)+diniPrivate::vectorSlack(nameHashes)+diniPrivate::vectorSlack(nameFilter)+
+                          diniPrivate::vectorSlack(nameIndex)+diniPrivate::vectorSlack(tombstones)+diniPrivate::vectorSlack(counterSlots);
+            return result;
+        }
+
+        void iniSection::shrinkToFit()
+        {
+            // The values are copied into a vector of the right size first, as copying them gives them room to grow again
+            compact();
+            sectionName.shrink_to_fit();
+            diniPrivate::shrinkVector(values);
+            for(std::vector<iniValue>::iterator value=values.begin(); value!=values.end(); ++value)
+                value->shrinkToFit();
+            diniPrivate::shrinkVector(nameHashes);
+            diniPrivate::shrinkVector(nameFilter);
+            diniPrivate::shrinkVector(nameIndex);
+            diniPrivate::shrinkVector(tombstones);
+            diniPrivate::shrinkVector(counterSlots);
+        }
+
         bool iniSection::valueExists(const std::string& name) const
+        { return tryGetValue(name)!=0; }
+
+        unsigned long long iniSection::fingerprint() const
         {
-            // Search for the section, return true if we find it, if not: return false
-            for(std::vector<iniValue>::const_iterator pos=values.begin(); pos!=values.end(); pos++)
+            // Add up the hashes of the values which aren't marked as erased (0 is used for an unknown fingerprint, so a sum of 0 isn't kept)
+            unsigned long long hash=contentHash.hash.load(std::memory_order_relaxed);
+            if(hash!=0)
+                return hash;
+            hash=diniPrivate::hashData(0, 0);
+            for(size_t pos=0; pos<values.size(); pos++)
             {
-                if(name==pos->name())
-                    return true;
+                if(tombstones.empty() || !tombstones[pos])
+                    hash+=diniPrivate::hashValue(values[pos].nameData(), values[pos].nameLength(), values[pos].valueData(), values[pos].valueLength());
             }
-            return false;
+            contentHash.hash.store(hash, std::memory_order_relaxed);
+            return hash;
+        }
+
+        iniSection::range iniSection::findPrefix(const std::string& prefix)
+        {
+            compact();
+            exposeValues();
+            std::pair<const size_t*, const size_t*> found=diniPrivate::indexPrefixRange(nameIndex, values, prefix, caseSensitive);
+            return range(values.empty() ? 0 : &values[0], found.first, found.second, "", caseSensitive);
+        }
+        iniSection::const_range iniSection::findPrefix(const std::string& prefix) const
+        {
+            std::pair<const size_t*, const size_t*> found=diniPrivate::indexPrefixRange(nameIndex, values, prefix, caseSensitive);
+            return const_range(values.empty() ? 0 : &values[0], found.first, found.second, "", caseSensitive, erasedMarks());
+        }
+
+        iniSection::range iniSection::findMatching(const std::string& pattern)
+        {
+            compact();
+            exposeValues();
+            // Look up the range of values starting with the literal part of the pattern, the range will filter out the values which don't match
+            std::pair<const size_t*, const size_t*> found=diniPrivate::indexPrefixRange(nameIndex, values, diniPrivate::globPrefix(pattern), caseSensitive);
+            return range(values.empty() ? 0 : &values[0], found.first, found.second, pattern, caseSensitive);
+        }
+        iniSection::const_range iniSection::findMatching(const std::string& pattern) const
+        {
+            // Look up the range of values starting with the literal part of the pattern, the range will filter out the values which don't match
+            std::pair<const size_t*, const size_t*> found=diniPrivate::indexPrefixRange(nameIndex, values, diniPrivate::globPrefix(pattern), caseSensitive);
+            return const_range(values.empty() ? 0 : &values[0], found.first, found.second, pattern, caseSensitive, erasedMarks());
         }
 
         iniValue& iniSection::operator[](const std::string& name)
         {return getValue(name);}
         iniValue iniSection::operator[](const std::string& name) const throw(unknownName)
         {return getValue(name);}
+        iniValue& iniSection::operator[](const iniKey& key)
+        {return getValue(key);}
+        iniValue iniSection::operator[](const iniKey& key) const throw(unknownName)
+        {return getValue(key);}
 
         iniSection& iniSection::operator=(const iniSection& other)
         {
-            // Only copy the values of the other section, ignore it's name
-            values=other.values;
+            // Only copy the values of the other section, ignore it's name (and whether it's case sensitive)
+            // The values are copy constructed, because assigning them (as std::vector::operator= does) would only copy their values and not their names
+            // The index can only be copied when it's sorted the same way
+            std::vector<iniValue>(other.values).swap(values);
+            contentHash=other.contentHash;
+            nameHashes=other.nameHashes;
+            nameFilter=other.nameFilter;
+            tombstones=other.tombstones;
+            tombstoneCount=other.tombstoneCount;
+            if(caseSensitive==other.caseSensitive)
+                nameIndex=other.nameIndex;
+            else
+                diniPrivate::indexRebuild(nameIndex, values, caseSensitive);
+            // The values are new to this section, so they get new counters (the section itself keeps its counter)
+            // The slots of the old values are released first, so the new ones mostly get them back
+            if(counter)
+            {
+                counter->release(counterSlots);
+                counterSlots.clear();
+                for(size_t pos=0; pos<values.size(); pos++)
+                    counterSlots.push_back(counter->addSlot());
+            }
             return *this;
         }
 
         iniSection::iterator iniSection::begin()
-        { return values.begin(); }
+        {
+            compact();
+            exposeValues();
+            return iterator(values.empty() ? 0 : &values[0], 0, values.size(), 0);
+        }
         iniSection::const_iterator iniSection::begin() const
-        { return values.begin(); }
+        { return const_iterator(values.empty() ? 0 : &values[0], 0, values.size(), erasedMarks()); }
         iniSection::reverse_iterator iniSection::rbegin()
-        { return values.rbegin(); }
+        { return reverse_iterator(end()); }
         iniSection::const_reverse_iterator iniSection::rbegin() const
-        { return values.rbegin(); }
+        { return const_reverse_iterator(end()); }
 
         iniSection::iterator iniSection::end()
-        { return values.end(); }
+        {
+            compact();
+            exposeValues();
+            return iterator(values.empty() ? 0 : &values[0], values.size(), values.size(), 0);
+        }
         iniSection::const_iterator iniSection::end() const
-        { return values.end(); }
+        { return const_iterator(values.empty() ? 0 : &values[0], values.size(), values.size(), erasedMarks()); }
         iniSection::reverse_iterator iniSection::rend()
-        { return values.rend(); }
+        { return reverse_iterator(begin()); }
         iniSection::const_reverse_iterator iniSection::rend() const
-        { return values.rend(); }
+        { return const_reverse_iterator(begin()); }
+
+    // Private:
+        void iniSection::applyValues(const std::vector<std::pair<bool, const iniValue*> >& changes)
+        {
+            // The index is used to find the values, so it may not contain any erased values
+            compact();
+            forgetFingerprint();
+            // Sort the changes by name (keeping the changes to the same value in order), so each value only has to be looked up once
+            std::vector<size_t> order(changes.size());
+            for(size_t i=0; i<order.size(); i++)
+                order[i]=i;
+            const bool caseSensitive=this->caseSensitive;
+            std::stable_sort(order.begin(), order.end(), [&changes, caseSensitive](const size_t& lhs, const size_t& rhs)
+            {
+                return diniPrivate::compareNames(changes[lhs].second->nameData(), changes[lhs].second->nameLength(),
+                                                 changes[rhs].second->nameData(), changes[rhs].second->nameLength(), caseSensitive)<0;
+            });
+
+            // Go through the changes per value, only the result of the last change to a value matters
+            // Existing values are changed in place (keeping the spelling of their name) or marked as erased, new values are collected first
+            std::vector<bool> erased(values.size(), false);
+            bool anyErased=false;
+            std::vector<iniValue> added;
+            for(size_t first=0, last=0; first<order.size(); first=last)
+            {
+                const iniValue& name=*changes[order[first]].second;
+                const iniValue* result=0;
+                for(last=first; last<order.size() && diniPrivate::sameName(changes[order[last]].second->nameData(), changes[order[last]].second->nameLength(),
+                                                                           name.nameData(), name.nameLength(), caseSensitive); last++)
+                    result=changes[order[last]].first ? 0 : changes[order[last]].second;
+
+                const size_t pos=diniPrivate::indexFind(nameIndex, values, name.nameData(), name.nameLength(), caseSensitive);
+                if(pos!=values.size())
+                {
+                    if(result)
+                        values[pos]=*result;
+                    else
+                        anyErased=erased[pos]=true;
+                }
+                else if(result)
+                    added.push_back(*result);
+            }
+
+            // Remove the erased values and add the new ones, and then update the index once
+            if(anyErased)
+            {
+                diniPrivate::compactItems(values, nameHashes, erased, added.size());
+                releaseSlots(erased);
+            }
+            else
+            {
+                values.reserve(values.size()+added.size());
+                nameHashes.reserve(values.size()+added.size());
+            }
+            for(std::vector<iniValue>::const_iterator pos=added.begin(); pos!=added.end(); ++pos)
+            {
+                values.push_back(*pos);
+                nameHashes.push_back(diniPrivate::hashName(pos->nameData(), pos->nameLength()));
+                if(counter)
+                    counterSlots.push_back(counter->addSlot());
+            }
+            if(anyErased || !added.empty())
+            {
+                diniPrivate::filterRebuild(nameFilter, nameHashes);
+                diniPrivate::indexRebuild(nameIndex, values, caseSensitive);
+            }
+        }
+
+        iniValue& iniSection::appendValue(const iniValue& value)
+        {
+            // Add the value to the end of the list, store the hash of its name and insert it in the index
+            values.push_back(value);
+            updateFingerprint(values.back(), true);
+            nameHashes.push_back(diniPrivate::hashName(value.nameData(), value.nameLength()));
+            if(!tombstones.empty())
+                tombstones.push_back(false);
+            if(counter)
+                counterSlots.push_back(counter->addSlot());
+            diniPrivate::filterAdded(nameFilter, nameHashes);
+            diniPrivate::indexInsert(nameIndex, values, values.size()-1, caseSensitive);
+            return values.back();
+        }
+
+        template<class T> void iniSection::assignValue(const std::string& name, const T& value)
+        {
+            // Search for the value by name, if it's found, assign the new value to it, if not, create it and assign the new value to it
+            if(iniValue* pos=existingValue(name))
+            {
+                updateFingerprint(*pos, false);
+                pos->setValue(value);
+                updateFingerprint(*pos, true);
+            }
+            else
+                appendValue(iniValue(name, value));
+        }
+
+        iniValue* iniSection::existingValue(const std::string& name)
+        {
+            const size_t pos=findValue(name.data(), name.length());
+            return pos!=values.size() ? &values[pos] : 0;
+        }
+        const iniValue* iniSection::existingValue(const std::string& name) const
+        {
+            const size_t pos=findValue(name.data(), name.length());
+            return pos!=values.size() ? &values[pos] : 0;
+        }
+
+        void iniSection::startCounting(const std::shared_ptr<accessCounter>& counter)
+        {
+            // Release the slots in the old counter, and give this section and each of its values a new slot
+            if(this->counter)
+            {
+                this->counter->release(sectionSlot);
+                this->counter->release(counterSlots);
+            }
+            this->counter=counter;
+            counterSlots.clear();
+            if(!counter)
+                return;
+            sectionSlot=counter->addSlot();
+            counterSlots.reserve(values.size());
+            for(size_t pos=0; pos<values.size(); pos++)
+                counterSlots.push_back(counter->addSlot());
+        }
+
+        void iniSection::releaseSlots(const std::vector<bool>& erased)
+        {
+            if(!counter)
+                return;
+            std::vector<size_t> slots;
+            for(size_t pos=0; pos<counterSlots.size(); pos++)
+            {
+                if(erased[pos])
+                    slots.push_back(counterSlots[pos]);
+            }
+            counter->release(slots);
+            diniPrivate::removeMarked(counterSlots, erased);
+        }
+
+        void iniSection::removeErased(const std::vector<bool>& erased)
+        {
+            // Copy the erased marks first, as they may be the tombstones themselves
+            const std::vector<bool> marks(erased);
+            // The values that were already marked aren't part of the fingerprint anymore, the others are taken out now
+            for(size_t pos=0; pos<values.size(); pos++)
+            {
+                if(marks[pos] && (tombstones.empty() || !tombstones[pos]))
+                    updateFingerprint(values[pos], false);
+            }
+            diniPrivate::compactItems(values, nameHashes, marks, 0);
+            releaseSlots(marks);
+            diniPrivate::filterRebuild(nameFilter, nameHashes);
+            diniPrivate::indexCompact(nameIndex, marks);
+            tombstones.clear();
+            tombstoneCount=0;
+        }
+
+        const std::vector<bool>* iniSection::erasedMarks() const
+        { return tombstoneCount!=0 ? &tombstones : 0; }
+        size_t iniSection::position(const iterator& pos)
+        { return pos-iterator(values.empty() ? 0 : &values[0], 0, values.size(), 0); }
+
+        void iniSection::forgetFingerprint()
+        {
+            // Only write when there's something to forget, so lookups don't keep writing to the section
+            if(contentHash.hash.load(std::memory_order_relaxed)!=0)
+                contentHash.hash.store(0, std::memory_order_relaxed);
+        }
+
+        void iniSection::updateFingerprint(const iniValue& value, const bool& added)
+        {
+            // The fingerprint is a sum, so one value can be added or subtracted (a result of 0 simply makes it unknown)
+            const unsigned long long hash=contentHash.hash.load(std::memory_order_relaxed);
+            if(hash==0)
+                return;
+            const unsigned long long change=diniPrivate::hashValue(value.nameData(), value.nameLength(), value.valueData(), value.valueLength());
+            contentHash.hash.store(added ? hash+change : hash-change, std::memory_order_relaxed);
+        }
+
+        void iniSection::exposeValues()
+        {
+            forgetFingerprint();
+            contentHash.exposed=true;
+        }
+
+        unsigned long long iniSection::keptFingerprint() const
+        { return contentHash.exposed ? 0 : fingerprint(); }
+
+        size_t iniSection::findValue(const char* name, const size_t& length) const
+        { return findValue(name, length, diniPrivate::hashName(name, length)); }
+
+        size_t iniSection::findValue(const char* name, const size_t& length, const unsigned int& hash) const
+        {
+            // Names which aren't in the filter certainly don't exist
+            // For the others, scan the (compact) array of hashes, and only compare the actual name when the hash matches
+            // Values which are marked as erased are skipped
+            if(!diniPrivate::filterMayContain(nameFilter, hash))
+                return values.size();
+            const unsigned int* hashes=nameHashes.empty() ? 0 : &nameHashes[0];
+            for(size_t pos=0; pos<nameHashes.size(); pos++)
+            {
+                if(hashes[pos]==hash && diniPrivate::sameName(values[pos].nameData(), values[pos].nameLength(), name, length, caseSensitive) &&
+                   (tombstones.empty() || !tombstones[pos]))
+                    return pos;
+            }
+            return values.size();
+        }
 }
@@ -14,8 +14,14 @@
 ************************************************************************************************************/
 
 #include "inivalue.h"
+#include "namerange.h"
+#include "inikey.h"
+#include "iniaccess.h"
+#include "inistats.h"
 #include <vector>
 #include <string>
+#include <memory>
+#include <atomic>
 
 namespace dini
 {
@@ -32,28 +38,51 @@ namespace dini
     class iniSection
     {
         public:
-            // Iterators
-            typedef std::vector<iniValue>::iterator iterator;
-            typedef std::vector<iniValue>::reverse_iterator reverse_iterator;
-            typedef std::vector<iniValue>::const_iterator const_iterator;
-            typedef std::vector<iniValue>::const_reverse_iterator const_reverse_iterator;
+            // Iterators (the const iterators skip the values marked as erased, see setEraseLimit())
+            typedef liveIterator<iniValue> iterator;
+            typedef std::reverse_iterator<iterator> reverse_iterator;
+            typedef liveIterator<const iniValue> const_iterator;
+            typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+            // Ranges, as returned by findPrefix() and findMatching()
+            typedef nameRange<iniValue> range;
+            typedef nameRange<const iniValue> const_range;
 
             // Construct by only giving a name
             iniSection(const std::string& name="name");
             // Construct by giving a name and another section to copy the values from (the name of the other section will be ignored)
             iniSection(const std::string& name, const iniSection& other);
+            // Copy a section with its name, the copy keeps counting accesses in the same slots as other (see iniFile::setAccessCounting())
+            iniSection(const iniSection& other);
+            ~iniSection();
 
             // Get the name of this section
             std::string name() const;
+            // Direct access to the name, without making a copy (the data is only valid until this section is changed)
+            const char* nameData() const;
+            size_t nameLength() const;
             // Set the name of this section, returns true if the name was changed succesfull, which is when the name is a valid name
             bool setName(const std::string& name);
 
             // Clear all values in this section
             void clear();
 
+            // Whether the names of values are case sensitive (which is the default)
+            // When they're not, "Key", "key" and "KEY" all refer to the same value, which keeps the spelling it was added with
+            // The sections in an iniFile get this setting from the file (see iniFile::setCaseSensitive())
+            bool isCaseSensitive() const;
+            void setCaseSensitive(const bool& caseSensitive);
+
             // Get a value by name
             iniValue& getValue(const std::string& name);
             iniValue getValue(const std::string& name) const throw(unknownName);
+            // Get a value by name without creating or throwing, returns a null pointer if the value doesn't exist
+            iniValue* tryGetValue(const std::string& name);
+            const iniValue* tryGetValue(const std::string& name) const;
+            // The same, using a key with a precomputed hash (see inikey.h)
+            iniValue& getValue(const iniKey& key);
+            iniValue getValue(const iniKey& key) const throw(unknownName);
+            iniValue* tryGetValue(const iniKey& key);
+            const iniValue* tryGetValue(const iniKey& key) const;
 
             // Assigns a value to a name
             void setValue(const std::string& name, const iniValue& value);
@@ -75,12 +104,66 @@ namespace dini
             void erase(const iterator& pos);
             // Erase a range of values, from first (included) to last (excluded)
             void erase(const iterator& first, const iterator& last);
+            // Erase all values for which predicate(value) returns true (it's given a const iniValue&), returns the number of erased values
+            // All values are checked first, and then removed in one pass, so this is much faster than erasing them one by one
+            template<class Predicate> size_t eraseIf(Predicate predicate)
+            {
+                // Values which are already marked as erased (see setEraseLimit()) are removed in the same pass
+                std::vector<bool> erased(tombstones.empty() ? std::vector<bool>(values.size(), false) : tombstones);
+                size_t count=0;
+                for(size_t pos=0; pos<values.size(); pos++)
+                {
+                    if(!erased[pos] && predicate(static_cast<const iniValue&>(values[pos])))
+                    {
+                        erased[pos]=true;
+                        count++;
+                    }
+                }
+                if(count!=0 || tombstoneCount!=0)
+                    removeErased(erased);
+                return count;
+            }
+            // Deferred erasing, which is off (0) by default: when the limit isn't 0, erase(name) only marks the value as erased
+            // Marked values can't be found by name anymore, but they're only actually removed (all at once) when more than limit values are marked,
+            // or as soon as the values of a non-const section are used by position (by the iterators, findPrefix(), findMatching() or compact())
+            // So erasing many values by name only moves the values once, and pointers to the other values stay valid in the meantime
+            // The const functions skip the marked values instead, so reading a const section never changes it (and it can be read by several threads at once)
+            void setEraseLimit(const size_t& limit);
+            size_t eraseLimit() const;
+            // Remove all values which are marked as erased
+            void compact();
+            // Get how much memory this section uses (see inistats.h)
+            sectionMemory memoryUsage() const;
+            // Release all memory that isn't used: remove the values marked as erased, and drop the spare capacity of the vectors and values
+            // The room to grow is left after adding and erasing values, so call this once a section won't change anymore (this copies all values once)
+            void shrinkToFit();
             // Checks whether a value exists
             bool valueExists(const std::string& name) const;
 
+            // Get a 64 bit hash of the names and values in this section (the order of the values and the name of the section itself aren't part of it)
+            // Two sections with the same values have the same fingerprint, so comparing fingerprints is a cheap way to see whether a section has changed
+            // (different sections could have the same fingerprint, but the chance is negligible)
+            // The fingerprint is computed once and then kept up to date by setValue(), addValue(), rename() and erase(), which only rehash the value they change
+            // Handing out a value for changing (by non-const getValue(), tryGetValue() or operator[], or the non-const iterators and ranges) forgets it,
+            // so it's computed again the next time. This section can't see the changes made through such a reference or pointer, so a reference
+            // which is still changed after the next call of this function (for example one taken before it) isn't seen: take it again to change the value
+            unsigned long long fingerprint() const;
+
+            // Get all values whose name starts with prefix, ordered by name
+            range findPrefix(const std::string& prefix);
+            const_range findPrefix(const std::string& prefix) const;
+            // Get all values whose name matches the glob pattern (where '*' matches anything and '?' matches any single character), ordered by name
+            // Only the values starting with the part of the pattern before the first wildcard are checked, so patterns like "server_*" are fast
+            range findMatching(const std::string& pattern);
+            const_range findMatching(const std::string& pattern) const;
+            // Note: these queries (and all lookups by name) use an index which is kept up to date by this class,
+            // so rename values using rename() instead of calling setName() on a value in this section
+
             // Gets a value by name
             iniValue& operator[](const std::string& name);
             iniValue operator[](const std::string& name) const throw(unknownName);
+            iniValue& operator[](const iniKey& key);
+            iniValue operator[](const iniKey& key) const throw(unknownName);
 
             // Copies all the values from another section in this one, ignoring the name of the other section
             iniSection& operator=(const iniSection& other);
@@ -100,8 +183,74 @@ namespace dini
             const_reverse_iterator rend() const;
 
         private:
+            friend class iniFile;
+
+            // Set or erase (when the first of the pair is true) the given values in the order they're given, but in one go
+            // Used by iniFile::apply(), the names have to be valid
+            void applyValues(const std::vector<std::pair<bool, const iniValue*> >& changes);
+            // Adds a value to the list of values (without checking if it already exists), and returns the added value
+            iniValue& appendValue(const iniValue& value);
+            // Set the value called name to value, or add it if it doesn't exist yet, used by the setValue() functions
+            template<class T> void assignValue(const std::string& name, const T& value);
+            // Get a value by name without counting the lookup (see iniFile::setAccessCounting()), used when setting a value
+            // and by the expansion cache of iniFile (which would otherwise count every check of a cached value)
+            iniValue* existingValue(const std::string& name);
+            const iniValue* existingValue(const std::string& name) const;
+            // Count the lookups of this section and its values in counter from now on (starting at 0), or stop counting when it's a null pointer
+            void startCounting(const std::shared_ptr<accessCounter>& counter);
+            // Release the counter slots of the values marked in erased and forget them (when counting)
+            void releaseSlots(const std::vector<bool>& erased);
+            // Remove the values marked in erased in one pass (and forget all tombstones)
+            void removeErased(const std::vector<bool>& erased);
+            // The marks of the values which are erased, or a null pointer when there aren't any (for the const iterators and ranges)
+            const std::vector<bool>* erasedMarks() const;
+            // The index in values of the value pos points to (pos is a non-const iterator, so nothing is marked)
+            size_t position(const iterator& pos);
+            // Forget the fingerprint, called when many values change at once
+            void forgetFingerprint();
+            // Take a value out of the fingerprint (before it's changed or erased) or put it in (after it's changed or added), when the fingerprint is known
+            void updateFingerprint(const iniValue& value, const bool& added);
+            // Called before a value is handed out for changing: forget the fingerprint, as this section won't see the changes
+            void exposeValues();
+            // The fingerprint when no value was ever handed out for changing (so it's certain to be up to date), or 0 otherwise
+            // Used by the expansion cache of iniFile to check a whole section at once, it checks the values it depends on one by one when this is 0
+            unsigned long long keptFingerprint() const;
+            // Get the position of the value with the given name, returns values.size() if there is no such value
+            size_t findValue(const char* name, const size_t& length) const;
+            size_t findValue(const char* name, const size_t& length, const unsigned int& hash) const;
+
+            // The values are stored in order, the hashes of their names are stored separately in the same order
+            // This way a lookup only scans the small hashes, and only touches a value itself when its hash matches
+            // Lookups for names that don't exist are mostly stopped by the Bloom filter over the hashes, without scanning anything
             std::string sectionName;
             std::vector<iniValue> values;
+            std::vector<unsigned int> nameHashes;
+            std::vector<unsigned long long> nameFilter;     // Bloom filter over nameHashes
+            std::vector<size_t> nameIndex;                  // Positions in values, sorted by the name of the value
+            bool caseSensitive;
+            // Deferred erasing, tombstones marks the values which are erased (it's empty when there aren't any)
+            std::vector<bool> tombstones;
+            size_t tombstoneCount;
+            size_t tombstoneLimit;
+            // Access counting, counterSlots holds the slot of each value in counter (in the same order as values), and sectionSlot the slot of this section
+            // A copy of a section keeps counting in the same slots (it owns them as well), counter is a null pointer when nothing is counted
+            std::shared_ptr<accessCounter> counter;
+            std::vector<size_t> counterSlots;
+            size_t sectionSlot;
+            // The fingerprint, computed when it's needed (it's 0 when it isn't known)
+            // It's atomic, as it may be computed by several threads reading this section at once
+            // exposed is set once a value is handed out for changing (see keptFingerprint()), a copy has its own values so it starts with exposed false
+            class fingerprintCache
+            {
+                public:
+                    fingerprintCache();
+                    fingerprintCache(const fingerprintCache& other);
+                    fingerprintCache& operator=(const fingerprintCache& other);
+
+                    std::atomic<unsigned long long> hash;
+                    bool exposed;
+            };
+            mutable fingerprintCache contentHash;
     };
 }
 
@@ -0,0 +1,857 @@
+#include "inisnapshot.h"
+#include "dini_private.h"
+#include "dini_io.h"
+
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define DINI_POSIX_SNAPSHOT
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <sys/mman.h>
+#else
+    #include <fstream>
+#endif
+
+namespace diniPrivate
+{
+    // The layout of a snapshot, all offsets are in bytes from the start of the snapshot
+    // The snapshot is stored in the byte order of the machine that published it, so it can only be shared on the same machine
+    const char snapshotMagic[8]={'D', 'I', 'N', 'I', 'S', 'N', 'A', 'P'};
+    const uint32_t snapshotVersion=4;
+    // Flags in the header
+    const uint32_t snapshotCaseInsensitive=1;          // The names are compared (and hashed) ignoring case
+
+    // Sections and values are looked up using a minimal perfect hash: the hash of the name selects a bucket, and the seed stored for
+    // that bucket selects the slot (one for each item), which holds the position of the only item that can have that name
+    // So a lookup only has to compare the name once. Seeds with snapshotDirectSlot set hold the slot itself (used for buckets with one item)
+    // A table without buckets (which only happens when two names have exactly the same hash) is searched in the sorted order instead
+    // Before that, the same hash is checked against a Bloom filter (see filterMayContain()), which stops most lookups for names that don't exist
+    const uint32_t snapshotDirectSlot=0x80000000u;
+
+    struct snapshotHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t sectionCount;
+        uint64_t generation;
+        uint64_t size;                  // Size of the whole snapshot
+        uint64_t valueCount;
+        uint64_t sectionsOffset;        // snapshotSection[sectionCount], in the original order
+        uint64_t sectionOrderOffset;    // uint32_t[sectionCount], positions of the sections sorted by name
+        uint64_t valuesOffset;          // snapshotValue[valueCount], the values of each section after each other, in the original order (see iniSnapshot::value)
+        uint64_t valueOrderOffset;      // uint32_t[valueCount], per section the positions of its values (within that section) sorted by name
+        uint64_t stringsOffset;         // All names and values
+        uint32_t flags;
+        uint32_t sectionBucketCount;
+        uint64_t sectionBucketsOffset;  // uint32_t[sectionBucketCount], the seeds of the perfect hash of the section names
+        uint64_t sectionSlotsOffset;    // uint32_t[sectionCount], the slots of the perfect hash of the section names
+        uint64_t valueBucketCount;
+        uint64_t valueBucketsOffset;    // uint32_t[valueBucketCount], per section the seeds of the perfect hash of its value names
+        uint64_t valueSlotsOffset;      // uint32_t[valueCount], per section the slots of the perfect hash of its value names
+        uint64_t sectionFilterWords;
+        uint64_t sectionFilterOffset;   // uint64_t[sectionFilterWords], the Bloom filter over the section names
+        uint64_t valueFilterWords;
+        uint64_t valueFilterOffset;     // uint64_t[valueFilterWords], per section the Bloom filter over its value names
+    };
+
+    struct snapshotSection
+    {
+        uint64_t nameOffset;
+        uint32_t nameLength;
+        uint32_t valueCount;
+        uint64_t firstValue;            // Position of the first value of this section in the values (and value order and value slots) table
+        uint64_t firstBucket;           // Position of the first seed of this section in the value buckets table
+        uint32_t bucketCount;
+        uint32_t filterWords;
+        uint64_t firstFilterWord;       // Position of the first word of the filter of this section in the value filter table
+    };
+
+    // This is how iniSnapshot::value is stored, the offset of a value is counted from the start of its own record,
+    // so the value can be read without knowing where the snapshot starts
+    struct snapshotValue
+    {
+        uint64_t offset;                // The name, directly followed by the value
+        uint32_t nameLength;
+        uint32_t valueLength;
+    };
+    static_assert(sizeof(snapshotValue)==sizeof(dini::iniSnapshot::value), "iniSnapshot::value has to have the layout of snapshotValue");
+
+    // Get the name of a value (of which the offset is counted from its own record)
+    inline const char* snapshotName(const snapshotValue& value)
+    { return reinterpret_cast<const char*>(&value)+value.offset; }
+
+    // Round up to a multiple of 64, so every table starts at a new cache line
+    inline uint64_t snapshotAlign(const uint64_t& offset)
+    { return (offset+63) & ~uint64_t(63); }
+
+    // Hash a name for the perfect hash (64 bit FNV-1a), ignoring case if caseSensitive is false
+    inline uint64_t snapshotHash(const char* name, const size_t& length, const bool& caseSensitive)
+    {
+        uint64_t hash=14695981039346656037ULL;
+        for(size_t i=0; i<length; i++)
+        {
+            hash^=static_cast<unsigned char>(caseSensitive ? name[i] : foldCase(name[i]));
+            hash*=1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // Get the slot of a hash in a perfect hash table with the given buckets, for count items (both have to be more than 0)
+    inline uint32_t snapshotSlot(const uint64_t& hash, const uint32_t* buckets, const uint32_t& bucketCount, const uint32_t& count)
+    {
+        const uint32_t seed=buckets[(hash>>32)%bucketCount];
+        if(seed & snapshotDirectSlot)
+            return seed & ~snapshotDirectSlot;
+        // Mix the seed into the hash (the finalizer of splitmix64)
+        uint64_t mixed=hash+(seed+1)*0x9E3779B97F4A7C15ULL;
+        mixed=(mixed^(mixed>>30))*0xBF58476D1CE4E5B9ULL;
+        mixed=(mixed^(mixed>>27))*0x94D049BB133111EBULL;
+        return static_cast<uint32_t>((mixed^(mixed>>31))%count);
+    }
+
+    // The number of buckets used for a perfect hash over count items (about three items per bucket)
+    inline uint32_t snapshotBucketCount(const size_t& count)
+    { return count==0 ? 0 : static_cast<uint32_t>(count/3+1); }
+
+    // Build a minimal perfect hash over hashes, filling buckets (bucketCount seeds) and slots (one for each hash)
+    // Returns false if that isn't possible, which is when two names have the same hash
+    bool buildPerfectHash(const std::vector<uint64_t>& hashes, uint32_t* buckets, const uint32_t& bucketCount, uint32_t* slots)
+    {
+        const uint32_t count=static_cast<uint32_t>(hashes.size());
+        if(count==0)
+            return true;
+        std::vector<uint64_t> sorted(hashes);
+        std::sort(sorted.begin(), sorted.end());
+        if(std::adjacent_find(sorted.begin(), sorted.end())!=sorted.end())
+            return false;
+
+        // Put the items in their buckets, and place the biggest buckets first (while most slots are still free)
+        std::vector<std::vector<uint32_t> > members(bucketCount);
+        for(uint32_t i=0; i<count; i++)
+            members[(hashes[i]>>32)%bucketCount].push_back(i);
+        std::vector<uint32_t> order(bucketCount);
+        for(uint32_t i=0; i<bucketCount; i++)
+            order[i]=i;
+        std::stable_sort(order.begin(), order.end(), [&members](const uint32_t& lhs, const uint32_t& rhs)
+        { return members[lhs].size()>members[rhs].size(); });
+
+        std::vector<bool> used(count, false);
+        std::vector<uint32_t> taken;
+        uint32_t nextFree=0;
+        for(std::vector<uint32_t>::const_iterator bucket=order.begin(); bucket!=order.end() && !members[*bucket].empty(); ++bucket)
+        {
+            const std::vector<uint32_t>& items=members[*bucket];
+            if(items.size()==1)
+            {
+                // A single item can simply get the next free slot
+                while(used[nextFree])
+                    nextFree++;
+                buckets[*bucket]=snapshotDirectSlot | nextFree;
+                used[nextFree]=true;
+                slots[nextFree]=items.front();
+                continue;
+            }
+            // Try seeds until all items of the bucket end up in different free slots (which should take far less than maxSeed tries)
+            const uint32_t maxSeed=1<<24;
+            uint32_t seed=0;
+            for(; seed<maxSeed; seed++)
+            {
+                buckets[*bucket]=seed;
+                taken.clear();
+                for(std::vector<uint32_t>::const_iterator item=items.begin(); item!=items.end(); ++item)
+                {
+                    const uint32_t slot=snapshotSlot(hashes[*item], buckets, bucketCount, count);
+                    if(used[slot] || std::find(taken.begin(), taken.end(), slot)!=taken.end())
+                        break;
+                    taken.push_back(slot);
+                }
+                if(taken.size()==items.size())
+                    break;
+            }
+            if(seed==maxSeed)
+                return false;
+            for(size_t i=0; i<items.size(); i++)
+            {
+                used[taken[i]]=true;
+                slots[taken[i]]=items[i];
+            }
+        }
+        return true;
+    }
+
+    // Whether count items of itemSize bytes starting at offset fit in size bytes, written so that it can't overflow
+    // The offset also has to be a multiple of 8, so the tables can be read in place
+    inline bool tableFits(const uint64_t& offset, const uint64_t& count, const uint64_t& itemSize, const uint64_t& size)
+    { return offset%8==0 && offset<=size && count<=(size-offset)/itemSize; }
+    // Whether [first, first+count) lies within [0, total), without overflowing
+    inline bool rangeFits(const uint64_t& first, const uint64_t& count, const uint64_t& total)
+    { return first<=total && count<=total-first; }
+    // Whether the positions in table (of count entries) are all less than count
+    inline bool positionsValid(const uint32_t* table, const uint64_t& count)
+    {
+        for(uint64_t i=0; i<count; i++)
+        {
+            if(table[i]>=count)
+                return false;
+        }
+        return true;
+    }
+    // Whether the seeds of a perfect hash only select slots that exist (see snapshotSlot(), slots which are computed are always less than count)
+    inline bool bucketsValid(const uint32_t* buckets, const uint64_t& bucketCount, const uint64_t& count)
+    {
+        for(uint64_t i=0; i<bucketCount; i++)
+        {
+            if((buckets[i] & snapshotDirectSlot) && (buckets[i] & ~snapshotDirectSlot)>=count)
+                return false;
+        }
+        return true;
+    }
+
+    // Check whether the header is from a snapshot, and whether all tables fit in the given size
+    bool snapshotValid(const snapshotHeader& header, const uint64_t& size)
+    {
+        if(std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic))!=0 || header.version!=snapshotVersion || header.size!=size)
+            return false;
+        return tableFits(header.sectionsOffset, header.sectionCount, sizeof(snapshotSection), size) &&
+               tableFits(header.sectionOrderOffset, header.sectionCount, sizeof(uint32_t), size) &&
+               tableFits(header.valuesOffset, header.valueCount, sizeof(snapshotValue), size) &&
+               tableFits(header.valueOrderOffset, header.valueCount, sizeof(uint32_t), size) &&
+               header.stringsOffset<=size &&
+               tableFits(header.sectionBucketsOffset, header.sectionBucketCount, sizeof(uint32_t), size) &&
+               tableFits(header.sectionSlotsOffset, header.sectionCount, sizeof(uint32_t), size) &&
+               tableFits(header.valueBucketsOffset, header.valueBucketCount, sizeof(uint32_t), size) &&
+               tableFits(header.valueSlotsOffset, header.valueCount, sizeof(uint32_t), size) &&
+               tableFits(header.sectionFilterOffset, header.sectionFilterWords, sizeof(uint64_t), size) &&
+               tableFits(header.valueFilterOffset, header.valueFilterWords, sizeof(uint64_t), size);
+    }
+
+    // Check every record of a snapshot whose header is valid (see snapshotValid()), so a damaged or forged file can't make a lookup read outside of it
+    // This checks each section and value once, and each entry of the order, slot and bucket tables
+    bool snapshotRecordsValid(const char* blob, const uint64_t& size)
+    {
+        const snapshotHeader& header=*reinterpret_cast<const snapshotHeader*>(blob);
+        const snapshotSection* sections=reinterpret_cast<const snapshotSection*>(blob+header.sectionsOffset);
+        const snapshotValue* values=reinterpret_cast<const snapshotValue*>(blob+header.valuesOffset);
+        const uint32_t* valueOrder=reinterpret_cast<const uint32_t*>(blob+header.valueOrderOffset);
+        const uint32_t* valueBuckets=reinterpret_cast<const uint32_t*>(blob+header.valueBucketsOffset);
+        const uint32_t* valueSlots=reinterpret_cast<const uint32_t*>(blob+header.valueSlotsOffset);
+        if(!positionsValid(reinterpret_cast<const uint32_t*>(blob+header.sectionOrderOffset), header.sectionCount) ||
+           (header.sectionBucketCount!=0 && !positionsValid(reinterpret_cast<const uint32_t*>(blob+header.sectionSlotsOffset), header.sectionCount)) ||
+           !bucketsValid(reinterpret_cast<const uint32_t*>(blob+header.sectionBucketsOffset), header.sectionBucketCount, header.sectionCount))
+            return false;
+        for(uint32_t i=0; i<header.sectionCount; i++)
+        {
+            const snapshotSection& section=sections[i];
+            if(!rangeFits(section.nameOffset, section.nameLength, size) || !rangeFits(section.firstValue, section.valueCount, header.valueCount) ||
+               !rangeFits(section.firstBucket, section.bucketCount, header.valueBucketCount) ||
+               !rangeFits(section.firstFilterWord, section.filterWords, header.valueFilterWords))
+                return false;
+            if(!positionsValid(valueOrder+section.firstValue, section.valueCount) ||
+               (section.bucketCount!=0 && !positionsValid(valueSlots+section.firstValue, section.valueCount)) ||
+               !bucketsValid(valueBuckets+section.firstBucket, section.bucketCount, section.valueCount))
+                return false;
+            for(uint64_t pos=section.firstValue; pos<section.firstValue+section.valueCount; pos++)
+            {
+                // The offset is counted from the record itself, which lies within the snapshot (the values table fits)
+                // Both lengths are 32 bit, so their sum can't overflow
+                const uint64_t record=header.valuesOffset+pos*sizeof(snapshotValue);
+                if(!rangeFits(values[pos].offset, uint64_t(values[pos].nameLength)+values[pos].valueLength, size-record))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    // Build a snapshot of file in out
+    void buildSnapshot(const dini::iniFile& file, const uint64_t& generation, std::vector<char>& out)
+    {
+        // First count everything, so the whole snapshot can be allocated at once
+        uint64_t sectionCount=0, valueCount=0, valueBucketCount=0, valueFilterWords=0, stringsSize=0;
+        for(dini::iniFile::const_iterator section=file.begin(); section!=file.end(); ++section)
+        {
+            sectionCount++;
+            stringsSize+=section->nameLength();
+            valueBucketCount+=snapshotBucketCount(std::distance(section->begin(), section->end()));
+            valueFilterWords+=filterWords(std::distance(section->begin(), section->end()));
+            for(dini::iniSection::const_iterator value=section->begin(); value!=section->end(); ++value)
+            {
+                valueCount++;
+                stringsSize+=value->nameLength()+value->valueLength();
+            }
+        }
+
+        const bool caseSensitive=file.isCaseSensitive();
+        snapshotHeader header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+        header.version=snapshotVersion;
+        header.sectionCount=static_cast<uint32_t>(sectionCount);
+        header.generation=generation;
+        header.valueCount=valueCount;
+        header.flags=caseSensitive ? 0 : snapshotCaseInsensitive;
+        header.sectionBucketCount=snapshotBucketCount(sectionCount);
+        header.valueBucketCount=valueBucketCount;
+        header.sectionFilterWords=filterWords(sectionCount);
+        header.valueFilterWords=valueFilterWords;
+        header.sectionsOffset=snapshotAlign(sizeof(snapshotHeader));
+        header.sectionOrderOffset=snapshotAlign(header.sectionsOffset+sectionCount*sizeof(snapshotSection));
+        header.sectionBucketsOffset=snapshotAlign(header.sectionOrderOffset+sectionCount*sizeof(uint32_t));
+        header.sectionSlotsOffset=snapshotAlign(header.sectionBucketsOffset+header.sectionBucketCount*sizeof(uint32_t));
+        header.valuesOffset=snapshotAlign(header.sectionSlotsOffset+sectionCount*sizeof(uint32_t));
+        header.valueOrderOffset=snapshotAlign(header.valuesOffset+valueCount*sizeof(snapshotValue));
+        header.valueBucketsOffset=snapshotAlign(header.valueOrderOffset+valueCount*sizeof(uint32_t));
+        header.valueSlotsOffset=snapshotAlign(header.valueBucketsOffset+valueBucketCount*sizeof(uint32_t));
+        header.sectionFilterOffset=snapshotAlign(header.valueSlotsOffset+valueCount*sizeof(uint32_t));
+        header.valueFilterOffset=snapshotAlign(header.sectionFilterOffset+header.sectionFilterWords*sizeof(uint64_t));
+        header.stringsOffset=snapshotAlign(header.valueFilterOffset+valueFilterWords*sizeof(uint64_t));
+        header.size=header.stringsOffset+stringsSize;
+
+        out.assign(header.size, 0);
+        char* blob=&out[0];
+        snapshotSection* sections=reinterpret_cast<snapshotSection*>(blob+header.sectionsOffset);
+        uint32_t* sectionOrder=reinterpret_cast<uint32_t*>(blob+header.sectionOrderOffset);
+        snapshotValue* values=reinterpret_cast<snapshotValue*>(blob+header.valuesOffset);
+        uint32_t* valueOrder=reinterpret_cast<uint32_t*>(blob+header.valueOrderOffset);
+        uint32_t* valueBuckets=reinterpret_cast<uint32_t*>(blob+header.valueBucketsOffset);
+        uint32_t* valueSlots=reinterpret_cast<uint32_t*>(blob+header.valueSlotsOffset);
+        unsigned long long* valueFilters=reinterpret_cast<unsigned long long*>(blob+header.valueFilterOffset);
+
+        // Copy all names and values into the string pool, and fill the tables
+        uint64_t strings=header.stringsOffset, valuePos=0, sectionPos=0, bucketPos=0, filterPos=0;
+        std::vector<uint64_t> hashes;
+        for(dini::iniFile::const_iterator section=file.begin(); section!=file.end(); ++section, ++sectionPos)
+        {
+            snapshotSection& record=sections[sectionPos];
+            record.nameOffset=strings;
+            record.nameLength=static_cast<uint32_t>(section->nameLength());
+            record.valueCount=static_cast<uint32_t>(std::distance(section->begin(), section->end()));
+            record.firstValue=valuePos;
+            record.firstBucket=bucketPos;
+            record.bucketCount=snapshotBucketCount(record.valueCount);
+            record.filterWords=static_cast<uint32_t>(filterWords(record.valueCount));
+            record.firstFilterWord=filterPos;
+            std::memcpy(blob+strings, section->nameData(), section->nameLength());
+            strings+=section->nameLength();
+            bucketPos+=record.bucketCount;
+            filterPos+=record.filterWords;
+
+            hashes.clear();
+            for(dini::iniSection::const_iterator value=section->begin(); value!=section->end(); ++value, ++valuePos)
+            {
+                values[valuePos].offset=strings-(header.valuesOffset+valuePos*sizeof(snapshotValue));
+                values[valuePos].nameLength=static_cast<uint32_t>(value->nameLength());
+                values[valuePos].valueLength=static_cast<uint32_t>(value->valueLength());
+                std::memcpy(blob+strings, value->nameData(), value->nameLength());
+                std::memcpy(blob+strings+value->nameLength(), value->valueData(), value->valueLength());
+                strings+=value->nameLength()+value->valueLength();
+                hashes.push_back(snapshotHash(value->nameData(), value->nameLength(), caseSensitive));
+            }
+
+            // Sort the values of this section by name, and build the perfect hash over their names
+            uint32_t* order=valueOrder+record.firstValue;
+            const snapshotValue* sectionValues=values+record.firstValue;
+            for(uint32_t i=0; i<record.valueCount; i++)
+                order[i]=i;
+            std::sort(order, order+record.valueCount, [sectionValues, caseSensitive](const uint32_t& lhs, const uint32_t& rhs)
+            {
+                return compareNames(snapshotName(sectionValues[lhs]), sectionValues[lhs].nameLength,
+                                    snapshotName(sectionValues[rhs]), sectionValues[rhs].nameLength, caseSensitive)<0;
+            });
+            if(!buildPerfectHash(hashes, valueBuckets+record.firstBucket, record.bucketCount, valueSlots+record.firstValue))
+                record.bucketCount=0;
+            for(std::vector<uint64_t>::const_iterator hash=hashes.begin(); hash!=hashes.end(); ++hash)
+                filterInsert(valueFilters+record.firstFilterWord, record.filterWords, *hash);
+        }
+
+        // Sort the sections by name, and build the perfect hash over their names
+        hashes.clear();
+        for(uint32_t i=0; i<sectionCount; i++)
+        {
+            sectionOrder[i]=i;
+            hashes.push_back(snapshotHash(blob+sections[i].nameOffset, sections[i].nameLength, caseSensitive));
+        }
+        std::sort(sectionOrder, sectionOrder+sectionCount, [blob, sections, caseSensitive](const uint32_t& lhs, const uint32_t& rhs)
+        {
+            return compareNames(blob+sections[lhs].nameOffset, sections[lhs].nameLength,
+                                blob+sections[rhs].nameOffset, sections[rhs].nameLength, caseSensitive)<0;
+        });
+        if(!buildPerfectHash(hashes, reinterpret_cast<uint32_t*>(blob+header.sectionBucketsOffset), header.sectionBucketCount, reinterpret_cast<uint32_t*>(blob+header.sectionSlotsOffset)))
+            header.sectionBucketCount=0;
+        for(std::vector<uint64_t>::const_iterator hash=hashes.begin(); hash!=hashes.end(); ++hash)
+            filterInsert(reinterpret_cast<unsigned long long*>(blob+header.sectionFilterOffset), header.sectionFilterWords, *hash);
+        std::memcpy(blob, &header, sizeof(header));
+    }
+
+    // Find name using the perfect hash if there is one (bucketCount isn't 0), or with a binary search through the sorted order otherwise
+    // Names that aren't in the filter (of filterWords words) are rejected before that, without looking at any of the items
+    // nameOf(pos) gives the name (data and length) of the item at pos, returns the position of the item, or count if it doesn't exist
+    template<class NameOf> size_t snapshotFind(const unsigned long long* filter, const size_t& filterWords, const uint32_t* buckets, const uint32_t& bucketCount,
+                                               const uint32_t* slots, const uint32_t* order, const size_t& count, const std::string& name, const NameOf& nameOf, const bool& caseSensitive)
+    {
+        const uint64_t hash=snapshotHash(name.data(), name.length(), caseSensitive);
+        if(count==0 || !filterMayContain(filter, filterWords, hash))
+            return count;
+        if(bucketCount!=0)
+        {
+            // The perfect hash gives the only item that can have this name, so there's exactly one name to compare
+            const uint32_t pos=slots[snapshotSlot(hash, buckets, bucketCount, static_cast<uint32_t>(count))];
+            const std::pair<const char*, size_t> candidate=nameOf(pos);
+            return sameName(candidate.first, candidate.second, name.data(), name.length(), caseSensitive) ? pos : count;
+        }
+
+        size_t first=0, last=count;
+        while(first<last)
+        {
+            const size_t middle=first+(last-first)/2;
+            const std::pair<const char*, size_t> middleName=nameOf(order[middle]);
+            const int result=compareNames(middleName.first, middleName.second, name.data(), name.length(), caseSensitive);
+            if(result==0)
+                return order[middle];
+            if(result<0)
+                first=middle+1;
+            else
+                last=middle;
+        }
+        return count;
+    }
+
+    // Find the part of order (count positions of values, sorted by name) with the values whose name starts with prefix
+    std::pair<const uint32_t*, const uint32_t*> snapshotPrefixRange(const uint32_t* order, const size_t& count, const dini::iniSnapshot::value* values,
+                                                                    const std::string& prefix, const bool& caseSensitive)
+    {
+        // Only the first prefix.length() characters of the names are compared, so all names starting with prefix compare equal to it
+        const uint32_t* first=std::lower_bound(order, order+count, prefix, [values, caseSensitive](const uint32_t& pos, const std::string& prefix)
+        { return compareNames(values[pos].nameData(), std::min(values[pos].nameLength(), prefix.length()), prefix.data(), prefix.length(), caseSensitive)<0; });
+        const uint32_t* last=std::upper_bound(first, order+count, prefix, [values, caseSensitive](const std::string& prefix, const uint32_t& pos)
+        { return compareNames(values[pos].nameData(), std::min(values[pos].nameLength(), prefix.length()), prefix.data(), prefix.length(), caseSensitive)>0; });
+        return std::pair<const uint32_t*, const uint32_t*>(first, last);
+    }
+
+    // Read the header of the snapshot in path, returns false if there's no (valid) snapshot
+    bool readSnapshotHeader(const std::string& path, snapshotHeader& header)
+    {
+#ifdef DINI_POSIX_SNAPSHOT
+        const int fd=::open(path.c_str(), O_RDONLY);
+        if(fd<0)
+            return false;
+        struct stat info;
+        const bool result=::fstat(fd, &info)==0 && ::pread(fd, &header, sizeof(header), 0)==static_cast<ssize_t>(sizeof(header)) &&
+                          snapshotValid(header, info.st_size);
+        ::close(fd);
+        return result;
+#else
+        std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+        if(!file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+            return false;
+        file.seekg(0, std::ios::end);
+        return snapshotValid(header, static_cast<uint64_t>(file.tellg()));
+#endif
+    }
+}
+
+namespace dini
+{
+// iniSnapshot::storage
+    // The memory the snapshot is stored in, which is either mapped from a file or owned by this object
+    class iniSnapshot::storage
+    {
+        public:
+            storage()
+                :blob(0), size(0), mapped(false){}
+            ~storage()
+            {
+#ifdef DINI_POSIX_SNAPSHOT
+                if(mapped)
+                    ::munmap(const_cast<char*>(blob), size);
+#endif
+            }
+
+            const diniPrivate::snapshotHeader& header() const
+            { return *reinterpret_cast<const diniPrivate::snapshotHeader*>(blob); }
+            const diniPrivate::snapshotSection* sections() const
+            { return reinterpret_cast<const diniPrivate::snapshotSection*>(blob+header().sectionsOffset); }
+            const uint32_t* sectionOrder() const
+            { return reinterpret_cast<const uint32_t*>(blob+header().sectionOrderOffset); }
+
+            // Take over a snapshot built in memory, which is moved to the start of a cache line if it isn't there already
+            void adopt(std::vector<char>& built)
+            {
+                owned.swap(built);
+                size=owned.size();
+                const size_t misalignment=reinterpret_cast<uintptr_t>(&owned[0])%64;
+                if(misalignment!=0)
+                {
+                    std::vector<char> aligned(size+63);
+                    const size_t offset=(64-reinterpret_cast<uintptr_t>(&aligned[0])%64)%64;
+                    std::memcpy(&aligned[offset], &owned[0], size);
+                    owned.swap(aligned);
+                    blob=&owned[offset];
+                }
+                else
+                    blob=&owned[0];
+            }
+
+            const char* blob;
+            size_t size;
+            bool mapped;                    // Whether blob is mapped from a file, if not it points into owned
+            std::vector<char> owned;
+
+        private:
+            // Not copyable
+            storage(const storage&);
+            storage& operator=(const storage&);
+    };
+
+// iniSnapshot::value
+    // Public:
+        std::string iniSnapshot::value::name() const
+        { return std::string(nameData(), nameSize); }
+        const char* iniSnapshot::value::nameData() const
+        { return reinterpret_cast<const char*>(this)+offset; }
+        size_t iniSnapshot::value::nameLength() const
+        { return nameSize; }
+        const char* iniSnapshot::value::valueData() const
+        { return nameData()+nameSize; }
+        size_t iniSnapshot::value::valueLength() const
+        { return valueSize; }
+
+        bool iniSnapshot::value::validateType(const valueType& type) const
+        {
+            // Try converting to the given value type using the non-throwing conversions, and return whether that was succesfull
+            switch(type)
+            {
+                case typeInt:       { int tmp;      return tryToInt(tmp);       }
+                case typeDouble:    { double tmp;   return tryToDouble(tmp);    }
+                case typeChar:      { char tmp;     return tryToChar(tmp);      }
+                case typeBool:      { bool tmp;     return tryToBool(tmp);      }
+                case typeString:    return true;        // Converting to a string will always be succesfull
+            }
+            return false;
+        }
+
+        int iniSnapshot::value::toInt() const throw(valueType)
+        {
+            int out=0;
+            if(!tryToInt(out))
+                throw typeInt;
+            return out;
+        }
+        double iniSnapshot::value::toDouble() const throw(valueType)
+        {
+            double out=0;
+            if(!tryToDouble(out))
+                throw typeDouble;
+            return out;
+        }
+        char iniSnapshot::value::toChar() const throw(valueType)
+        {
+            char out=0;
+            if(!tryToChar(out))
+                throw typeChar;
+            return out;
+        }
+        bool iniSnapshot::value::toBool() const throw(valueType)
+        {
+            bool out=false;
+            if(!tryToBool(out))
+                throw typeBool;
+            return out;
+        }
+        std::string iniSnapshot::value::toString() const
+        { return std::string(valueData(), valueSize); }
+
+        bool iniSnapshot::value::tryToInt(int& out) const
+        {
+            // Only values the fast parser doesn't accept as a whole (like "12 apples", of which a stream takes the 12) are copied into a stream,
+            // so the result is the same as that of iniValue::tryToInt()
+            if(diniPrivate::parseInt(valueData(), valueData()+valueSize, out))
+                return true;
+            diniPrivate::numberParser parser;
+            return parser.parse(toString(), out);
+        }
+        bool iniSnapshot::value::tryToDouble(double& out) const
+        {
+            if(diniPrivate::parseDouble(valueData(), valueData()+valueSize, out))
+                return true;
+            diniPrivate::numberParser parser;
+            return parser.parse(toString(), out);
+        }
+        bool iniSnapshot::value::tryToChar(char& out) const
+        {
+            if(valueSize!=1)
+                return false;
+            out=*valueData();
+            return true;
+        }
+        bool iniSnapshot::value::tryToBool(bool& out) const
+        {
+            // "0" or "false" gives false, "true" or any other number gives true
+            if((valueSize==1 && *valueData()=='0') || diniPrivate::strCaseCompare(valueData(), valueSize, "false"))
+            {
+                out=false;
+                return true;
+            }
+            if(diniPrivate::strCaseCompare(valueData(), valueSize, "true"))
+            {
+                out=true;
+                return true;
+            }
+            double tmp=0;
+            if(!tryToDouble(tmp))
+                return false;
+            out=(tmp!=0);
+            return true;
+        }
+
+        iniValue iniSnapshot::value::toIniValue() const
+        { return iniValue(name(), toString()); }
+
+// iniSnapshot::section
+    // Public:
+        std::string iniSnapshot::section::name() const
+        {
+            const diniPrivate::snapshotSection* section=static_cast<const diniPrivate::snapshotSection*>(record);
+            return std::string(blob+section->nameOffset, section->nameLength);
+        }
+        size_t iniSnapshot::section::size() const
+        { return static_cast<const diniPrivate::snapshotSection*>(record)->valueCount; }
+
+        iniSnapshot::section::const_iterator iniSnapshot::section::begin() const
+        {
+            const diniPrivate::snapshotSection* section=static_cast<const diniPrivate::snapshotSection*>(record);
+            return reinterpret_cast<const value*>(blob+reinterpret_cast<const diniPrivate::snapshotHeader*>(blob)->valuesOffset)+section->firstValue;
+        }
+        iniSnapshot::section::const_iterator iniSnapshot::section::end() const
+        { return begin()+size(); }
+
+        bool iniSnapshot::section::valueExists(const std::string& name) const
+        { return find(name)!=size(); }
+
+        const iniSnapshot::value& iniSnapshot::section::getValue(const std::string& name) const throw(unknownName)
+        {
+            // Search for the value by name, if it's found, return it.
+            // If not, throw an error
+            const size_t pos=find(name);
+            if(pos==size())
+                throw unknownName(name);
+            return valueAt(pos);
+        }
+        const iniSnapshot::value& iniSnapshot::section::operator[](const std::string& name) const throw(unknownName)
+        { return getValue(name); }
+
+        const iniSnapshot::value* iniSnapshot::section::tryGetValue(const std::string& name) const
+        {
+            const size_t pos=find(name);
+            return pos!=size() ? begin()+pos : 0;
+        }
+
+        const iniSnapshot::value& iniSnapshot::section::valueAt(const size_t& pos) const
+        { return begin()[pos]; }
+
+        iniSnapshot::section::const_range iniSnapshot::section::findPrefix(const std::string& prefix) const
+        { return prefixRange(prefix, ""); }
+        iniSnapshot::section::const_range iniSnapshot::section::findMatching(const std::string& pattern) const
+        {
+            // Look up the range of values starting with the literal part of the pattern, the range will filter out the values which don't match
+            return prefixRange(diniPrivate::globPrefix(pattern), pattern);
+        }
+
+        iniSection iniSnapshot::section::toIniSection() const
+        {
+            iniSection result(name());
+            result.setCaseSensitive((reinterpret_cast<const diniPrivate::snapshotHeader*>(blob)->flags & diniPrivate::snapshotCaseInsensitive)==0);
+            for(const_iterator value=begin(); value!=end(); ++value)
+                result.addValue(value->toIniValue());
+            return result;
+        }
+
+    // Private:
+        iniSnapshot::section::section(const char* blob, const void* record)
+            :blob(blob), record(record){}
+
+        size_t iniSnapshot::section::find(const std::string& name) const
+        {
+            // Look the name up in the filter and perfect hash of this section (or its sorted values)
+            const diniPrivate::snapshotHeader& header=*reinterpret_cast<const diniPrivate::snapshotHeader*>(blob);
+            const diniPrivate::snapshotSection* section=static_cast<const diniPrivate::snapshotSection*>(record);
+            const value* values=begin();
+            const uint32_t* buckets=reinterpret_cast<const uint32_t*>(blob+header.valueBucketsOffset)+section->firstBucket;
+            const uint32_t* slots=reinterpret_cast<const uint32_t*>(blob+header.valueSlotsOffset)+section->firstValue;
+            const uint32_t* order=reinterpret_cast<const uint32_t*>(blob+header.valueOrderOffset)+section->firstValue;
+            const unsigned long long* filter=reinterpret_cast<const unsigned long long*>(blob+header.valueFilterOffset)+section->firstFilterWord;
+            return diniPrivate::snapshotFind(filter, section->filterWords, buckets, section->bucketCount, slots, order, section->valueCount, name, [values](const uint32_t& pos)
+            { return std::pair<const char*, size_t>(values[pos].nameData(), values[pos].nameLength()); }, (header.flags & diniPrivate::snapshotCaseInsensitive)==0);
+        }
+
+        iniSnapshot::section::const_range iniSnapshot::section::prefixRange(const std::string& prefix, const std::string& pattern) const
+        {
+            const diniPrivate::snapshotHeader& header=*reinterpret_cast<const diniPrivate::snapshotHeader*>(blob);
+            const diniPrivate::snapshotSection* section=static_cast<const diniPrivate::snapshotSection*>(record);
+            const uint32_t* order=reinterpret_cast<const uint32_t*>(blob+header.valueOrderOffset)+section->firstValue;
+            const bool caseSensitive=(header.flags & diniPrivate::snapshotCaseInsensitive)==0;
+            const std::pair<const uint32_t*, const uint32_t*> found=diniPrivate::snapshotPrefixRange(order, size(), begin(), prefix, caseSensitive);
+            return const_range(begin(), found.first, found.second, pattern, caseSensitive);
+        }
+
+// iniSnapshot
+    // Public:
+        iniSnapshot::iniSnapshot()
+        {
+            // An empty file gives a snapshot without any sections
+            std::shared_ptr<storage> empty(new storage);
+            std::vector<char> built;
+            diniPrivate::buildSnapshot(iniFile(), 0, built);
+            empty->adopt(built);
+            data=empty;
+        }
+
+        iniSnapshot::iniSnapshot(const iniFile& file)
+        {
+            std::shared_ptr<storage> frozen(new storage);
+            std::vector<char> built;
+            diniPrivate::buildSnapshot(file, 0, built);
+            frozen->adopt(built);
+            data=frozen;
+        }
+
+        void iniSnapshot::publish(const iniFile& file, const std::string& path) throw(fileError)
+        {
+            // The new snapshot gets the generation after the one it replaces (if there is one)
+            diniPrivate::snapshotHeader previous;
+            const uint64_t generation=diniPrivate::readSnapshotHeader(path, previous) ? previous.generation+1 : 1;
+            std::vector<char> blob;
+            diniPrivate::buildSnapshot(file, generation, blob);
+
+            // Write the snapshot to a temporary file next to the target, and rename it over the target when it's complete,
+            // so processes never see a half written snapshot, and the ones attached to the old snapshot can keep using it
+            // Note that this assumes there's only one process publishing to the same path at a time
+            const std::string tempPath=path+".tmp";
+            diniPrivate::fileWriter writer;
+            if(writer.open(tempPath)!=diniPrivate::ioOk)
+                throw fileError(tempPath, fileError::openForWritingError);
+            if(writer.write(&blob[0], blob.size())!=diniPrivate::ioOk || writer.close()!=diniPrivate::ioOk)
+            {
+                std::remove(tempPath.c_str());
+                throw fileError(tempPath, fileError::writeError);
+            }
+#ifndef DINI_POSIX_SNAPSHOT
+            // rename() doesn't replace existing files everywhere, so remove the old one first (which makes the swap not atomic here)
+            std::remove(path.c_str());
+#endif
+            if(std::rename(tempPath.c_str(), path.c_str())!=0)
+            {
+                std::remove(tempPath.c_str());
+                throw fileError(path, fileError::openForWritingError);
+            }
+        }
+
+        void iniSnapshot::attach(const std::string& path) throw(fileError)
+        {
+            std::shared_ptr<storage> attached(new storage);
+#ifdef DINI_POSIX_SNAPSHOT
+            // Map the whole file read-only, the pages are shared with every other process that has it mapped
+            // The mapping stays valid when a new snapshot is published, because that replaces the file instead of changing it
+            const int fd=::open(path.c_str(), O_RDONLY);
+            if(fd<0)
+                throw fileError(path, fileError::openForReadingError);
+            struct stat info;
+            if(::fstat(fd, &info)!=0 || static_cast<size_t>(info.st_size)<sizeof(diniPrivate::snapshotHeader))
+            {
+                ::close(fd);
+                throw fileError(path, fileError::readError);
+            }
+            void* mapping=::mmap(0, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if(mapping==MAP_FAILED)
+                throw fileError(path, fileError::readError);
+            attached->blob=static_cast<const char*>(mapping);
+            attached->size=info.st_size;
+            attached->mapped=true;
+#else
+            // Without mmap() the snapshot is read into memory, so it isn't shared, but it's still loaded without parsing anything
+            std::string contents;
+            const diniPrivate::ioResult result=diniPrivate::readWholeFile(path, contents);
+            if(result==diniPrivate::ioOpenError)
+                throw fileError(path, fileError::openForReadingError);
+            if(result!=diniPrivate::ioOk || contents.size()<sizeof(diniPrivate::snapshotHeader))
+                throw fileError(path, fileError::readError);
+            std::vector<char> read(contents.begin(), contents.end());
+            attached->adopt(read);
+#endif
+            // Check the whole snapshot before it's used, not only the header
+            if(!diniPrivate::snapshotValid(attached->header(), attached->size) || !diniPrivate::snapshotRecordsValid(attached->blob, attached->size))
+                throw fileError(path, fileError::readError);
+
+            // Only replace the current snapshot once the new one is valid
+            data=attached;
+            this->path=path;
+        }
+
+        bool iniSnapshot::isStale() const
+        {
+            // Snapshots which aren't attached to a file never become stale
+            if(path.empty())
+                return false;
+            diniPrivate::snapshotHeader current;
+            return diniPrivate::readSnapshotHeader(path, current) && current.generation!=generation();
+        }
+
+        uint64_t iniSnapshot::generation() const
+        { return data->header().generation; }
+
+        bool iniSnapshot::isCaseSensitive() const
+        { return (data->header().flags & diniPrivate::snapshotCaseInsensitive)==0; }
+
+        size_t iniSnapshot::size() const
+        { return data->header().sectionCount; }
+
+        bool iniSnapshot::sectionExists(const std::string& name) const
+        { return find(name)!=size(); }
+
+        iniSnapshot::section iniSnapshot::getSection(const std::string& name) const throw(unknownName)
+        {
+            // Search for the section by name, if it's found, return it.
+            // If not, throw an error
+            const size_t pos=find(name);
+            if(pos==size())
+                throw unknownName(name);
+            return sectionAt(pos);
+        }
+        iniSnapshot::section iniSnapshot::operator[](const std::string& name) const throw(unknownName)
+        { return getSection(name); }
+
+        iniSnapshot::section iniSnapshot::sectionAt(const size_t& pos) const
+        { return section(data->blob, data->sections()+pos); }
+
+        iniFile iniSnapshot::toIniFile() const
+        {
+            iniFile result;
+            result.setCaseSensitive(isCaseSensitive());
+            for(size_t pos=0; pos<size(); pos++)
+            {
+                const section current=sectionAt(pos);
+                result.setSection(current.name(), current.toIniSection());
+            }
+            return result;
+        }
+
+    // Private:
+        size_t iniSnapshot::find(const std::string& name) const
+        {
+            // Look the name up in the filter and perfect hash of the sections (or the sorted sections)
+            const diniPrivate::snapshotHeader& header=data->header();
+            const diniPrivate::snapshotSection* sections=data->sections();
+            const char* blob=data->blob;
+            return diniPrivate::snapshotFind(reinterpret_cast<const unsigned long long*>(blob+header.sectionFilterOffset), header.sectionFilterWords,
+                                             reinterpret_cast<const uint32_t*>(blob+header.sectionBucketsOffset), header.sectionBucketCount,
+                                             reinterpret_cast<const uint32_t*>(blob+header.sectionSlotsOffset), data->sectionOrder(), size(), name,
+                                             [blob, sections](const uint32_t& pos)
+            { return std::pair<const char*, size_t>(blob+sections[pos].nameOffset, sections[pos].nameLength); }, isCaseSensitive());
+        }
+}
@@ -0,0 +1,166 @@
+#ifndef INISNAPSHOT_H
+#define INISNAPSHOT_H
+
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* This code is under the GPLv3 license.                                                                     *
+* That means that you're free to use and edit this code,                                                    *
+* as long as you publish any changes you make using this license.                                           *
+*                                                                                                           *
+* For the full license, see gpl3.txt or gpl3.html.                                                          *
+************************************************************************************************************/
+
+#include "inifile.h"
+#include <string>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace dini
+{
+    // An immutable image of an iniFile, stored in one block of memory which only uses offsets (no pointers),
+    // so it can be written to a file (for example in /dev/shm) and mapped read-only by many processes at once
+    // Each process then queries the sections and values directly from the shared memory, without loading or parsing anything
+    //
+    // Publishing a new version writes a new file and renames it over the old one, which is an atomic swap:
+    // processes that are attached to the old version can keep using it, and can check with isStale() whether a newer one is available
+    //
+    // A snapshot can also be made in memory (see iniFile::freeze()), as a faster read-only version of a file that won't be changed anymore
+    // Sections and values are looked up using a minimal perfect hash over their names, so a lookup only has to compare a name once
+    class iniSnapshot
+    {
+        public:
+            // A read-only value in the snapshot, which is read directly from the memory of the snapshot (nothing is copied to look it up or convert it)
+            // It's a record of the snapshot itself, so it's only handed out by reference or pointer, and only valid as long as the snapshot it came from exists
+            class value
+            {
+                public:
+                    // Get the name of this value
+                    std::string name() const;
+                    // Direct access to the name and value in the snapshot, without making a copy
+                    const char* nameData() const;
+                    size_t nameLength() const;
+                    const char* valueData() const;
+                    size_t valueLength() const;
+
+                    // The same conversions as those of iniValue, which give the same results, but parse the number in place
+                    bool validateType(const valueType& type) const;
+                    int toInt() const throw(valueType);
+                    double toDouble() const throw(valueType);
+                    char toChar() const throw(valueType);
+                    bool toBool() const throw(valueType);
+                    std::string toString() const;
+                    bool tryToInt(int& out) const;
+                    bool tryToDouble(double& out) const;
+                    bool tryToChar(char& out) const;
+                    bool tryToBool(bool& out) const;
+
+                    // Copy the name and value to a normal (changable) iniValue
+                    iniValue toIniValue() const;
+
+                private:
+                    // Only exists inside a snapshot, so it can't be constructed or copied
+                    value();
+                    value(const value& other);
+                    value& operator=(const value& other);
+
+                    // The record as it's stored in the snapshot, offset goes from the start of this record to the name, which is directly followed by the value
+                    uint64_t offset;
+                    uint32_t nameSize;
+                    uint32_t valueSize;
+            };
+
+            // A read-only view on a section in the snapshot, only valid as long as the snapshot it came from exists
+            class section
+            {
+                public:
+                    // Iterator over the values, in the original order
+                    typedef const value* const_iterator;
+                    // Range of values, as returned by findPrefix() and findMatching()
+                    typedef nameRange<const value, uint32_t> const_range;
+
+                    // Get the name of this section
+                    std::string name() const;
+                    // Get the number of values in this section
+                    size_t size() const;
+
+                    // Get iterator to the beginning and end of the values
+                    const_iterator begin() const;
+                    const_iterator end() const;
+
+                    // Check whether a value exists
+                    bool valueExists(const std::string& name) const;
+                    // Get a value by name, throws unknownName if it doesn't exist
+                    const value& getValue(const std::string& name) const throw(unknownName);
+                    const value& operator[](const std::string& name) const throw(unknownName);
+                    // Get a value by name without throwing, returns a null pointer if it doesn't exist
+                    const value* tryGetValue(const std::string& name) const;
+                    // Get a value by its position in the section (in the original order), pos has to be smaller than size()
+                    const value& valueAt(const size_t& pos) const;
+
+                    // Get all values whose name starts with prefix, or matches the glob pattern (see globMatch()), ordered by name
+                    const_range findPrefix(const std::string& prefix) const;
+                    const_range findMatching(const std::string& pattern) const;
+
+                    // Convert this section back to a normal (changable) iniSection
+                    iniSection toIniSection() const;
+
+                private:
+                    friend class iniSnapshot;
+                    section(const char* blob, const void* record);
+
+                    // Get the position of the value with the given name, returns size() if it doesn't exist
+                    size_t find(const std::string& name) const;
+                    // Get the range of values whose name starts with prefix, which only contains the ones matching pattern (when it isn't empty)
+                    const_range prefixRange(const std::string& prefix, const std::string& pattern) const;
+
+                    const char* blob;
+                    const void* record;
+            };
+
+            // Creates an empty snapshot
+            iniSnapshot();
+            // Creates a snapshot of the given file in memory (so it isn't shared), the same as file.freeze()
+            explicit iniSnapshot(const iniFile& file);
+
+            // Write a snapshot of the given file to path, replacing the previous snapshot there in one atomic step
+            // The generation of the new snapshot is one higher than that of the snapshot it replaces
+            static void publish(const iniFile& file, const std::string& path) throw(fileError);
+            // Attach to the snapshot in path, which is mapped read-only (and thus shared with other processes attached to it)
+            // A fileError with type readError is thrown if the file isn't a valid snapshot, every section and value in it is checked before it's used
+            void attach(const std::string& path) throw(fileError);
+            // Check whether a newer snapshot has been published to the path this snapshot was attached to
+            bool isStale() const;
+            // Get the generation of this snapshot, which is increased by one each time a snapshot is published to the same path
+            uint64_t generation() const;
+
+            // Whether the names of sections and values are case sensitive, which is taken from the file the snapshot was made of
+            bool isCaseSensitive() const;
+            // Get the number of sections
+            size_t size() const;
+            // Check whether a section exists
+            bool sectionExists(const std::string& name) const;
+            // Get a section by name, throws unknownName if it doesn't exist
+            section getSection(const std::string& name) const throw(unknownName);
+            section operator[](const std::string& name) const throw(unknownName);
+            // Get a section by its position (in the original order), pos has to be smaller than size()
+            section sectionAt(const size_t& pos) const;
+
+            // Convert this snapshot back to a normal (changable) iniFile
+            iniFile toIniFile() const;
+
+        private:
+            class storage;
+
+            // Get the position of the section with the given name, returns size() if it doesn't exist
+            size_t find(const std::string& name) const;
+
+            std::shared_ptr<const storage> data;
+            std::string path;
+    };
+}
+
+#endif // INISNAPSHOT_H
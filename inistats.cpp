@@ -0,0 +1,80 @@
+#include "inistats.h"
+
+#include <sstream>
+#include <iomanip>
+
+namespace diniPrivate
+{
+    // Add one gauge (with its help and type lines) to out
+    void addGauge(std::ostringstream& out, const std::string& name, const std::string& help, const std::string& label, const double& value)
+    {
+        out<<"# HELP "<<name<<' '<<help<<'\n';
+        out<<"# TYPE "<<name<<" gauge\n";
+        out<<name<<"{file=\""<<label<<"\"} "<<value<<'\n';
+    }
+}
+
+namespace dini
+{
+// ioStats
+    // Public:
+        ioStats::ioStats(const operationType& operation, const std::string& filename)
+            :operation(operation), filename(filename), succeeded(true), bytes(0), lines(0), sections(0), values(0), escapes(0), valueAllocations(0),
+             ioTime(0), tokenizeTime(0), valueTime(0), totalTime(0){}
+
+        std::string ioStats::toPrometheus(const std::string& prefix) const
+        {
+            // Label values have to escape \, " and newlines
+            std::string label;
+            for(std::string::const_iterator pos=filename.begin(); pos!=filename.end(); ++pos)
+            {
+                switch(*pos)
+                {
+                    case '\\':  label+="\\\\";  break;
+                    case '"':   label+="\\\"";  break;
+                    case '\n':  label+="\\n";   break;
+                    default:    label+=*pos;    break;
+                }
+            }
+
+            // The times are reported in seconds, as is usual for Prometheus
+            const std::string name=prefix+(operation==opLoad ? "_load" : "_save");
+            const double second=1e9;
+            std::ostringstream out;
+            out<<std::setprecision(12);
+            diniPrivate::addGauge(out, name+"_success", "Whether the file was processed succesfully (1) or not (0)", label, succeeded ? 1 : 0);
+            diniPrivate::addGauge(out, name+"_bytes", "Bytes read or written", label, static_cast<double>(bytes));
+            diniPrivate::addGauge(out, name+"_lines", "Lines read or written", label, static_cast<double>(lines));
+            diniPrivate::addGauge(out, name+"_sections", "Sections in the file", label, static_cast<double>(sections));
+            diniPrivate::addGauge(out, name+"_values", "Values in the file", label, static_cast<double>(values));
+            diniPrivate::addGauge(out, name+"_escapes", "Escape sequences decoded or written", label, static_cast<double>(escapes));
+            diniPrivate::addGauge(out, name+"_value_allocations", "Values which needed an allocation of their own", label, static_cast<double>(valueAllocations));
+            diniPrivate::addGauge(out, name+"_io_seconds", "Time spent reading or writing the file", label, ioTime/second);
+            if(operation==opLoad)
+                diniPrivate::addGauge(out, name+"_tokenize_seconds", "Time spent stripping whitespaces and comments", label, tokenizeTime/second);
+            diniPrivate::addGauge(out, name+"_value_seconds", "Time spent building or formatting the sections and values", label, valueTime/second);
+            diniPrivate::addGauge(out, name+"_seconds", "Total time", label, totalTime/second);
+            return out.str();
+        }
+
+// sectionMemory
+    // Public:
+        sectionMemory::sectionMemory()
+            :names(0), values(0), objects(0), lookup(0), slack(0){}
+
+        size_t sectionMemory::total() const
+        { return names+values+objects+lookup+slack; }
+
+// memoryReport
+    // Public:
+        memoryReport::memoryReport()
+            :objects(0), lookup(0), slack(0){}
+
+        size_t memoryReport::total() const
+        {
+            size_t result=objects+lookup+slack;
+            for(std::vector<sectionMemory>::const_iterator section=sections.begin(); section!=sections.end(); ++section)
+                result+=section->total();
+            return result;
+        }
+}
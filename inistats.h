@@ -0,0 +1,94 @@
+#ifndef INISTATS_H
+#define INISTATS_H
+
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* This code is under the GPLv3 license.                                                                     *
+* That means that you're free to use and edit this code,                                                    *
+* as long as you publish any changes you make using this license.                                           *
+*                                                                                                           *
+* For the full license, see gpl3.txt or gpl3.html.                                                          *
+************************************************************************************************************/
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstddef>
+
+namespace dini
+{
+    // What was done while loading or saving a file, and how long each part took
+    // This is passed to the instrumentation hook of an iniFile (see iniFile::setInstrumentation()) each time it loads or saves a file
+    struct ioStats
+    {
+        enum operationType
+        {
+            opLoad,
+            opSave
+        };
+
+        ioStats(const operationType& operation=opLoad, const std::string& filename="");
+
+        operationType operation;             // Whether the file was loaded or saved
+        std::string filename;                // The file that was loaded or saved
+        bool succeeded;                      // False if loading or saving failed (the exception is thrown after the hook is called)
+
+        unsigned long long bytes;            // Bytes read or written (for the file itself, included files aren't counted)
+        unsigned long long lines;            // Lines read or written
+        unsigned long long sections;         // Sections loaded (including the ones from included files) or saved
+        unsigned long long values;           // Values loaded (including the ones from included files) or saved
+        unsigned long long escapes;          // Escape sequences decoded while loading, or written while saving
+        unsigned long long valueAllocations; // Values which needed an allocation of their own, as they didn't fit inside the iniValue itself
+
+        // Where the time went, in nanoseconds
+        unsigned long long ioTime;           // Reading or writing the file
+        unsigned long long tokenizeTime;     // Stripping whitespaces and comments from the lines (only when loading)
+        unsigned long long valueTime;        // Building the sections and values from the lines, or formatting them when saving
+        unsigned long long totalTime;        // Everything, including waiting for included files and building the index
+
+        // Get these statistics in the Prometheus text format, as gauges named prefix_load_... or prefix_save_...
+        // with the filename as a label, for example: dini_load_bytes{file="config.ini"} 1234
+        std::string toPrometheus(const std::string& prefix="dini") const;
+    };
+
+    // Hook that's called with the statistics each time a file is loaded or saved (see iniFile::setInstrumentation())
+    // The hook is called on the thread that loaded or saved the file, anything it throws is caught and ignored
+    typedef std::function<void(const ioStats&)> instrumentation;
+
+    // The memory used by a section, as given by iniSection::memoryUsage() (all sizes are in bytes)
+    // Names and values which fit inside their iniValue (which is the case for most values) are part of objects, and don't use any memory of their own
+    struct sectionMemory
+    {
+        sectionMemory();
+
+        std::string name;       // Name of the section
+        size_t names;           // Allocations holding the name of the section and the names of the values stored on the heap
+        size_t values;          // Allocations holding the values stored on the heap
+        size_t objects;         // The iniValue objects themselves
+        size_t lookup;          // Hashes, filter and index used to look up values by name (and the slots of the access counters)
+        size_t slack;           // Memory that's allocated but not used (spare capacity of the vectors and allocations above), which shrinkToFit() releases
+
+        // Everything together (not counting the iniSection object itself)
+        size_t total() const;
+    };
+
+    // The memory used by a file, as given by iniFile::memoryUsage() (all sizes are in bytes)
+    // The cache of getExpanded() and the access counters (see iniFile::setAccessCounting()) aren't counted
+    struct memoryReport
+    {
+        memoryReport();
+
+        std::vector<sectionMemory> sections;    // Every section, in the order of the file
+        size_t objects;         // The iniFile and iniSection objects themselves
+        size_t lookup;          // Hashes, filter and index used to look up sections by name
+        size_t slack;           // Spare capacity of the vectors above, which shrinkToFit() releases
+
+        // Everything together, including the sections
+        size_t total() const;
+    };
+}
+
+#endif // INISTATS_H
@@ -3,68 +3,93 @@
 
 #include <sstream>
 #include <iomanip>
+#include <cstring>
 
 namespace dini
 {
 // iniValue
     // Public:
         iniValue::iniValue(const std::string& name)
-            :strName(diniPrivate::validName(name)?name:"name"), currValue(""){}
+            :nameSize(0), typeTag(storedNone), valueSize(0)
+        { init(name, "", 0); }
         iniValue::iniValue(const std::string& name, const iniValue& other)
-            :strName(diniPrivate::validName(name)?name:"name"), currValue(other.currValue){}
+            :nameSize(0), typeTag(storedNone), valueSize(0)
+        { init(name, other.valueData(), other.valueLength()); }
+        iniValue::iniValue(const iniValue& other)
+            :nameSize(0), typeTag(storedNone), valueSize(0)
+        { copyValue(other.nameData(), other.nameLength(), other); }
 
         iniValue::iniValue(const std::string& name, const int& value)
-            :strName(diniPrivate::validName(name)?name:"name"), currValue(intToString(value)){}
+            :nameSize(0), typeTag(storedNone), valueSize(0)
+        {
+            const std::string str=intToString(value);
+            init(name, str.data(), str.length());
+        }
         iniValue::iniValue(const std::string& name, const double& value)
-            :strName(diniPrivate::validName(name)?name:"name"), currValue(doubleToString(value)){}
+            :nameSize(0), typeTag(storedNone), valueSize(0)
+        {
+            const std::string str=doubleToString(value);
+            init(name, str.data(), str.length());
+        }
         iniValue::iniValue(const std::string& name, const char& value)
-            :strName(diniPrivate::validName(name)?name:"name"), currValue(1, value){}
+            :nameSize(0), typeTag(storedNone), valueSize(0)
+        { init(name, &value, 1); }
         iniValue::iniValue(const std::string& name, const bool& value)
-            :strName(diniPrivate::validName(name)?name:"name"), currValue(boolToString(value)){}
+            :nameSize(0), typeTag(storedNone), valueSize(0)
+        {
+            const std::string str=boolToString(value);
+            init(name, str.data(), str.length());
+        }
         iniValue::iniValue(const std::string& name, const std::string& value)
-            :strName(diniPrivate::validName(name)?name:"name"), currValue(value){}
+            :nameSize(0), typeTag(storedNone), valueSize(0)
+        { init(name, value.data(), value.length()); }
         iniValue::iniValue(const std::string& name, const char* value)
-            :strName(diniPrivate::validName(name)?name:"name"), currValue(value){}
+            :nameSize(0), typeTag(storedNone), valueSize(0)
+        { init(name, value, std::strlen(value)); }
+
+        iniValue::~iniValue()
+        {
+            if(onHeap())
+                delete[] storage.heap.data;
+        }
 
         std::string iniValue::name() const
-        { return strName; }
+        { return std::string(nameData(), nameSize); }
         bool iniValue::setName(const std::string& newName)
         {
             // Check if the name is valid, if it is, rename and return true, if not, return false
             if(diniPrivate::validName(newName))
             {
-                strName=newName;
+                copyValue(newName.data(), newName.length(), *this);
                 return true;
             }
             return false;
         }
 
+        const char* iniValue::nameData() const
+        { return onHeap() ? storage.heap.data : storage.inlineData; }
+        size_t iniValue::nameLength() const
+        { return nameSize; }
+
         bool iniValue::validateType(const valueType& type) const
         {
-            // Just try converting to the given value type, if that doesn't throw any errors, we return true, if it does throw errors we return false
-            try
+            // Try converting to the given value type using the non-throwing conversions, and return whether that was succesfull
+            switch(type)
             {
-                switch(type)
-                {
-                    case typeInt:       toInt();    break;
-                    case typeDouble:    toDouble(); break;
-                    case typeChar:      toChar();   break;
-                    case typeBool:      toBool();   break;
-                    case typeString:    return true;        // Converting to a string will always be succesfull
-                }
+                case typeInt:       { int tmp;      return tryToInt(tmp);       }
+                case typeDouble:    { double tmp;   return tryToDouble(tmp);    }
+                case typeChar:      { char tmp;     return tryToChar(tmp);      }
+                case typeBool:      { bool tmp;     return tryToBool(tmp);      }
+                case typeString:    return true;        // Converting to a string will always be succesfull
             }
-            catch(...)
-            { return false; }
-            return true;
+            return false;
         }
 
         int iniValue::toInt() const throw(valueType)
         {
             // Try converting the string to an int, if it fails, throw an error
             int out=0;
-            std::stringstream stream(currValue);
-            stream>>out;
-            if(stream.fail())
+            if(!tryToInt(out))
                 throw typeInt;
             return out;
         }
@@ -72,51 +97,329 @@ namespace dini
         {
             // Try converting the string to a double, if it fails, throw an error
             double out=0;
-            std::stringstream stream(currValue);
-            stream>>out;
-            if(stream.fail())
+            if(!tryToDouble(out))
                 throw typeDouble;
             return out;
         }
         char iniValue::toChar() const throw(valueType)
         {
-            // Just return the first character of the string, this can't be done if the string is empty
-            if(currValue.length()!=1)
+            // Try converting the string to a char, if it fails, throw an error
+            char out=0;
+            if(!tryToChar(out))
                 throw typeChar;
-            return currValue[0];
+            return out;
         }
         bool iniValue::toBool() const throw(valueType)
         {
-            // "0" or "false" gives false, "true" or any other number gives true
-            if(currValue=="0" || diniPrivate::strCaseCompare(currValue, "false"))
+            // Try converting the string to a bool, if it fails, throw an error
+            bool out=false;
+            if(!tryToBool(out))
+                throw typeBool;
+            return out;
+        }
+        std::string iniValue::toString() const
+        { return std::string(valueData(), valueSize); }
+
+        bool iniValue::tryToInt(int& out) const
+        {
+            // A value in which inferType() found an int has already been converted
+            if(typeTag==storedInt)
+            {
+                std::memcpy(&out, typedSlot(), sizeof(int));
+                return true;
+            }
+            // Try converting the string to an int, only store the result if it succeeded
+            int tmp=0;
+            std::stringstream stream(toString());
+            stream>>tmp;
+            if(stream.fail())
                 return false;
-            if(diniPrivate::strCaseCompare(currValue, "true"))
+            out=tmp;
+            return true;
+        }
+        bool iniValue::tryToDouble(double& out) const
+        {
+            // A value in which inferType() found a number has already been converted
+            if(typeTag==storedInt)
+            {
+                int number=0;
+                std::memcpy(&number, typedSlot(), sizeof(int));
+                out=number;
+                return true;
+            }
+            if(typeTag==storedDouble)
+            {
+                std::memcpy(&out, typedSlot(), sizeof(double));
                 return true;
-            try
-            { return toDouble()!=0; }
-            catch(...)
-            { throw typeBool; }
+            }
+            // Try converting the string to a double, only store the result if it succeeded
+            double tmp=0;
+            std::stringstream stream(toString());
+            stream>>tmp;
+            if(stream.fail())
+                return false;
+            out=tmp;
+            return true;
+        }
+        bool iniValue::tryToChar(char& out) const
+        {
+            // Just return the first character of the string, this can't be done if the string hasn't got exactly one character
+            if(valueSize!=1)
+                return false;
+            out=*valueData();
+            return true;
+        }
+        bool iniValue::tryToBool(bool& out) const
+        {
+            // "0" or "false" gives false, "true" or any other number gives true
+            // When inferType() found a bool or number, that's used instead of looking at the string again
+            if(typeTag==storedBool)
+            {
+                out=(*typedSlot()!=0);
+                return true;
+            }
+            if(typeTag==storedInt || typeTag==storedDouble)
+            {
+                double number=0;
+                tryToDouble(number);
+                out=(number!=0);
+                return true;
+            }
+            if((valueSize==1 && *valueData()=='0') || diniPrivate::strCaseCompare(valueData(), valueSize, "false"))
+            {
+                out=false;
+                return true;
+            }
+            if(diniPrivate::strCaseCompare(valueData(), valueSize, "true"))
+            {
+                out=true;
+                return true;
+            }
+            double tmp=0;
+            if(!tryToDouble(tmp))
+                return false;
+            out=(tmp!=0);
+            return true;
+        }
+
+        valueType iniValue::inferType()
+        {
+            typeTag=storedNone;
+            char* slot=typedSlot();
+            if(slot==0)
+                return typeString;
+
+            // When the fast parsers accept the whole value they give exactly the same number as the stream in the normal conversions,
+            // so converting it later gives the same result as it would have without inferType()
+            // (and a whole int converts to exactly the same double as well, except for -0 which is kept as a double to keep its sign)
+            const char* first=valueData();
+            const char* last=first+valueSize;
+            int intValue=0;
+            double doubleValue=0;
+            if(diniPrivate::parseInt(first, last, intValue) && (intValue!=0 || std::memchr(first, '-', valueSize)==0))
+            {
+                std::memcpy(slot, &intValue, sizeof(int));
+                typeTag=storedInt;
+                return typeInt;
+            }
+            if(diniPrivate::parseDouble(first, last, doubleValue))
+            {
+                std::memcpy(slot, &doubleValue, sizeof(double));
+                typeTag=storedDouble;
+                return typeDouble;
+            }
+            bool boolValue=false;
+            if((diniPrivate::strCaseCompare(first, valueSize, "true") || diniPrivate::strCaseCompare(first, valueSize, "false")) && tryToBool(boolValue))
+            {
+                *slot=boolValue;
+                typeTag=storedBool;
+                return typeBool;
+            }
+            return typeString;
+        }
+        valueType iniValue::inferredType() const
+        {
+            switch(typeTag)
+            {
+                case storedInt:     return typeInt;
+                case storedDouble:  return typeDouble;
+                case storedBool:    return typeBool;
+            }
+            return typeString;
+        }
+
+        size_t iniValue::listSize(const char& separator) const
+        {
+            // Count the items by jumping from separator to separator
+            if(valueSize==0)
+                return 0;
+            size_t count=1;
+            const char* end=valueData()+valueSize;
+            for(const char* pos=listItemEnd(valueData(), separator); pos!=end; pos=listItemEnd(pos+1, separator))
+                count++;
+            return count;
+        }
+
+        std::vector<std::string> iniValue::toList(const char& separator) const
+        {
+            // Split the value at every unescaped separator, and remove the escape characters from the items
+            std::vector<std::string> out;
+            if(valueSize==0)
+                return out;
+            const char* end=valueData()+valueSize;
+            for(const char* pos=valueData(); ; pos++)
+            {
+                const char* itemEnd=listItemEnd(pos, separator);
+                out.push_back(std::string());
+                for(; pos!=itemEnd; pos++)
+                {
+                    if(*pos=='\\' && pos+1!=itemEnd)
+                        pos++;
+                    out.back()+=*pos;
+                }
+                if(itemEnd==end)
+                    break;
+            }
+            return out;
+        }
+
+        size_t iniValue::toIntArray(int* out, const size_t& capacity, const char& separator) const throw(valueType)
+        {
+            // Convert the items one by one, directly from the stored value
+            if(valueSize==0)
+                return 0;
+            size_t count=0;
+            const char* end=valueData()+valueSize;
+            for(const char* pos=valueData(); ; pos++, count++)
+            {
+                const char* itemEnd=listItemEnd(pos, separator);
+                int number=0;
+                if(!diniPrivate::parseInt(pos, itemEnd, number))
+                    throw typeInt;
+                if(count<capacity)
+                    out[count]=number;
+                if((pos=itemEnd)==end)
+                    return count+1;
+            }
+        }
+        size_t iniValue::toDoubleArray(double* out, const size_t& capacity, const char& separator) const throw(valueType)
+        {
+            // Convert the items one by one, directly from the stored value
+            if(valueSize==0)
+                return 0;
+            size_t count=0;
+            const char* end=valueData()+valueSize;
+            for(const char* pos=valueData(); ; pos++, count++)
+            {
+                const char* itemEnd=listItemEnd(pos, separator);
+                double number=0;
+                if(!diniPrivate::parseDouble(pos, itemEnd, number))
+                    throw typeDouble;
+                if(count<capacity)
+                    out[count]=number;
+                if((pos=itemEnd)==end)
+                    return count+1;
+            }
+        }
+        void iniValue::toIntArray(std::vector<int>& out, const char& separator) const throw(valueType)
+        {
+            out.resize(listSize(separator));
+            if(!out.empty())
+                toIntArray(&out[0], out.size(), separator);
+        }
+        void iniValue::toDoubleArray(std::vector<double>& out, const char& separator) const throw(valueType)
+        {
+            out.resize(listSize(separator));
+            if(!out.empty())
+                toDoubleArray(&out[0], out.size(), separator);
+        }
+
+        void iniValue::setList(const std::vector<std::string>& items, const char& separator)
+        {
+            // Join the items, putting a \ before every separator or \ inside an item
+            std::string list;
+            for(std::vector<std::string>::const_iterator pos=items.begin(); pos!=items.end(); ++pos)
+            {
+                if(pos!=items.begin())
+                    list+=separator;
+                for(std::string::const_iterator strPos=pos->begin(); strPos!=pos->end(); ++strPos)
+                {
+                    if(*strPos==separator || *strPos=='\\')
+                        list+='\\';
+                    list+=*strPos;
+                }
+            }
+            setValue(list);
+        }
+        void iniValue::setList(const std::vector<int>& items, const char& separator)
+        {
+            // Numbers never need to be escaped, so just join them
+            std::string list;
+            for(std::vector<int>::const_iterator pos=items.begin(); pos!=items.end(); ++pos)
+            {
+                if(pos!=items.begin())
+                    list+=separator;
+                list+=intToString(*pos);
+            }
+            setValue(list);
+        }
+        void iniValue::setList(const std::vector<double>& items, const char& separator)
+        {
+            // Numbers never need to be escaped, so just join them
+            std::string list;
+            for(std::vector<double>::const_iterator pos=items.begin(); pos!=items.end(); ++pos)
+            {
+                if(pos!=items.begin())
+                    list+=separator;
+                list+=doubleToString(*pos);
+            }
+            setValue(list);
+        }
+
+        const char* iniValue::valueData() const
+        { return nameData()+nameSize; }
+        size_t iniValue::valueLength() const
+        { return valueSize; }
+        bool iniValue::isStoredInline() const
+        { return !onHeap(); }
+        size_t iniValue::heapSize() const
+        { return onHeap() ? storage.heap.capacity : 0; }
+
+        void iniValue::shrinkToFit()
+        {
+            // Only keep room for the number remembered by inferType(), if there is one
+            if(!onHeap())
+                return;
+            const size_t used=nameSize+valueSize;
+            const size_t capacity=used+(typeTag!=storedNone ? static_cast<size_t>(typedSlotSize) : 0);
+            if(storage.heap.capacity<=capacity)
+                return;
+            char* data=new char[capacity];
+            std::memcpy(data, storage.heap.data, used);
+            if(typeTag!=storedNone)
+                std::memcpy(data+capacity-typedSlotSize, typedSlot(), typedSlotSize);
+            delete[] storage.heap.data;
+            storage.heap.data=data;
+            storage.heap.capacity=capacity;
         }
-        std::string iniValue::toString() const
-        { return currValue; }
 
         void iniValue::setValue(const iniValue& other)
-        { currValue = other.currValue; }
+        { copyValue(nameData(), nameSize, other); }
         void iniValue::setValue(const int& value)
-        { currValue=intToString(value); }
+        { setValue(intToString(value)); }
         void iniValue::setValue(const double& value)
-        { currValue=doubleToString(value); }
+        { setValue(doubleToString(value)); }
         void iniValue::setValue(const char& value)
-        { currValue=value; }
+        { setValueData(&value, 1); }
         void iniValue::setValue(const bool& value)
-        { currValue=boolToString(value); }
+        { setValue(boolToString(value)); }
         void iniValue::setValue(const std::string& value)
-        { currValue=value; }
+        { setValueData(value.data(), value.length()); }
         void iniValue::setValue(const char* value)
-        { currValue=value; }
+        { setValueData(value, std::strlen(value)); }
 
         iniValue& iniValue::operator=(const iniValue& other)
-        { currValue=other.currValue; return *this; }
+        { setValue(other); return *this; }
         iniValue& iniValue::operator=(const int& value)
         { setValue(value); return *this; }
         iniValue& iniValue::operator=(const double& value)
@@ -131,19 +434,19 @@ namespace dini
         { setValue(value); return *this; }
 
         iniValue& iniValue::operator+=(const iniValue& other)
-        { currValue+=other.currValue; return *this; }
+        { appendValueData(other.valueData(), other.valueLength()); return *this; }
         iniValue& iniValue::operator+=(const int& value) throw(valueType)
         { setValue(toDouble()+value); return *this; }
         iniValue& iniValue::operator+=(const double& value) throw(valueType)
         { setValue(toDouble()+value); return *this; }
         iniValue& iniValue::operator+=(const char& value)
-        { currValue+=value; return *this; }
+        { appendValueData(&value, 1); return *this; }
         iniValue& iniValue::operator+=(const bool& value) throw(valueType)
         { setValue(toDouble()+value); return *this; }
         iniValue& iniValue::operator+=(const std::string& value)
-        { currValue+=value; return *this; }
+        { appendValueData(value.data(), value.length()); return *this; }
         iniValue& iniValue::operator+=(const char* value)
-        { currValue+=value; return *this; }
+        { appendValueData(value, std::strlen(value)); return *this; }
 
         iniValue& iniValue::operator-=(const iniValue& other) throw(valueType)
         { setValue(toDouble()-other.toDouble()); return *this; }
@@ -160,9 +463,120 @@ namespace dini
         { return !toBool(); }
 
         bool iniValue::operator==(const iniValue& other) const
-        { return currValue==other.currValue; }
+        { return valueSize==other.valueSize && std::memcmp(valueData(), other.valueData(), valueSize)==0; }
         bool iniValue::operator!=(const iniValue& other) const
-        { return currValue!=other.currValue; }
+        { return !(*this==other); }
+
+    // Private:
+        bool iniValue::onHeap() const
+        { return nameSize+valueSize>inlineCapacity; }
+
+        void iniValue::init(const std::string& name, const char* value, const size_t& valueLength)
+        {
+            // Only use the name if it's valid, if not, use the default name
+            if(diniPrivate::validName(name))
+                assign(name.data(), name.length(), value, valueLength);
+            else
+                assign("name", 4, value, valueLength);
+        }
+
+        void iniValue::assign(const char* name, const size_t& nameLength, const char* value, const size_t& valueLength)
+        {
+            // Note that name and value may point into our own storage, so we have to be careful not to overwrite them before they're copied
+            const size_t total=nameLength+valueLength;
+            if(total<=inlineCapacity)
+            {
+                // It fits in the object itself, build it in a temporary buffer first, then release the heap buffer (if any) and copy it in place
+                char tmp[inlineCapacity];
+                std::memcpy(tmp, name, nameLength);
+                std::memcpy(tmp+nameLength, value, valueLength);
+                if(onHeap())
+                    delete[] storage.heap.data;
+                std::memcpy(storage.inlineData, tmp, total);
+            }
+            else if(onHeap() && storage.heap.capacity>=total)
+            {
+                // The current heap buffer is big enough, move the value first as the name can only point to the start of the buffer
+                std::memmove(storage.heap.data+nameLength, value, valueLength);
+                std::memmove(storage.heap.data, name, nameLength);
+            }
+            else
+            {
+                // Allocate a new heap buffer (with some room to grow), copy everything to it and only then release the old buffer
+                const size_t capacity=total+total/2;
+                char* data=new char[capacity];
+                std::memcpy(data, name, nameLength);
+                std::memcpy(data+nameLength, value, valueLength);
+                if(onHeap())
+                    delete[] storage.heap.data;
+                storage.heap.data=data;
+                storage.heap.capacity=capacity;
+            }
+            nameSize=static_cast<unsigned int>(nameLength);
+            valueSize=static_cast<unsigned int>(valueLength);
+            typeTag=storedNone;
+        }
+
+        void iniValue::setValueData(const char* value, const size_t& length)
+        { assign(nameData(), nameSize, value, length); }
+
+        void iniValue::appendValueData(const char* value, const size_t& length)
+        {
+            // If there's enough room left, just copy the data behind the current value
+            // If not, allocate a bigger heap buffer and copy everything to it
+            const size_t total=nameSize+valueSize+length;
+            if(total<=inlineCapacity || (onHeap() && storage.heap.capacity>=total))
+                std::memmove(const_cast<char*>(valueData())+valueSize, value, length);
+            else
+            {
+                const size_t capacity=total+total/2;
+                char* data=new char[capacity];
+                std::memcpy(data, nameData(), nameSize+valueSize);
+                std::memcpy(data+nameSize+valueSize, value, length);
+                if(onHeap())
+                    delete[] storage.heap.data;
+                storage.heap.data=data;
+                storage.heap.capacity=capacity;
+            }
+            valueSize+=static_cast<unsigned int>(length);
+            typeTag=storedNone;
+        }
+
+        const char* iniValue::listItemEnd(const char* pos, const char& separator) const
+        {
+            // Walk to the next separator, skipping any escaped characters
+            const char* end=valueData()+valueSize;
+            for(; pos!=end && *pos!=separator; pos++)
+            {
+                if(*pos=='\\' && pos+1!=end)
+                    pos++;
+            }
+            return pos;
+        }
+
+        void iniValue::copyValue(const char* name, const size_t& nameLength, const iniValue& other)
+        {
+            // Keep what was remembered of other's value before anything is changed (other may be this object)
+            const unsigned int type=other.typeTag;
+            char number[typedSlotSize]={};
+            if(type!=storedNone)
+                std::memcpy(number, other.typedSlot(), typedSlotSize);
+            assign(name, nameLength, other.valueData(), other.valueLength());
+            char* slot=typedSlot();
+            if(type!=storedNone && slot!=0)
+            {
+                std::memcpy(slot, number, typedSlotSize);
+                typeTag=type;
+            }
+        }
+
+        char* iniValue::typedSlot() const
+        {
+            const size_t size=onHeap() ? storage.heap.capacity : static_cast<size_t>(inlineCapacity);
+            if(nameSize+valueSize+typedSlotSize>size)
+                return 0;
+            return const_cast<char*>(nameData())+size-typedSlotSize;
+        }
 
 // Functions:
     std::string intToString(const int& myInt)
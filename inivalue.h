@@ -14,6 +14,8 @@
 ************************************************************************************************************/
 
 #include <string>
+#include <vector>
+#include <cstddef>
 
 namespace dini
 {
@@ -41,11 +43,17 @@ namespace dini
             iniValue(const std::string& name, const bool& value);
             iniValue(const std::string& name, const std::string& value);
             iniValue(const std::string& name, const char* value);
+            // Copy constructor, copies both the name and the value
+            iniValue(const iniValue& other);
+            ~iniValue();
 
             // Get the name of this iniValue
             std::string name() const;
             // Set the name of this iniValue, returns true if renamed succesfull (that is, if the name is a valid name)
             bool setName(const std::string& newName);
+            // Direct access to the name as it's stored, without making a copy (the data is only valid until this iniValue is changed)
+            const char* nameData() const;
+            size_t nameLength() const;
 
             // Checks if it's possible to convert to the given type
             bool validateType(const valueType& type) const;
@@ -61,6 +69,54 @@ namespace dini
             // Returns the value of this iniValue as a string, note that this function is always succesfull (in contrary to the other conversion functions)
             std::string toString() const;
 
+            // Non-throwing versions of the conversion functions above
+            // If the conversion is succesfull the result is stored in out and true is returned, if not out is left untouched and false is returned
+            bool tryToInt(int& out) const;
+            bool tryToDouble(double& out) const;
+            bool tryToChar(char& out) const;
+            bool tryToBool(bool& out) const;
+
+            // Parse the value once and remember the int, double or bool it holds, so the conversions to that type don't have to parse it again
+            // The number is kept in room inside this iniValue that isn't used by the name and value, so this doesn't take any extra memory
+            // (but when there's no room left, which only happens for long names or values, nothing is remembered)
+            // The value itself is kept as it is, so it's still saved exactly as it was loaded
+            // Returns the type that was found, or typeString if the value isn't a number or bool (or couldn't be remembered)
+            // What's remembered is forgotten as soon as the value is changed, and is kept when the value is copied
+            valueType inferType();
+            // Get the type remembered by inferType(), or typeString if nothing is remembered
+            valueType inferredType() const;
+
+            // List values: the value can also be used as a list of items, separated by the given separator
+            // A separator or \ inside an item is escaped by putting a \ before it, an empty value is an empty list
+            // Get the number of items in the list
+            size_t listSize(const char& separator=',') const;
+            // Get all items in the list as strings
+            std::vector<std::string> toList(const char& separator=',') const;
+            // Convert all items in the list to ints or doubles at once, and store them in out, which has room for capacity numbers
+            // Returns the number of items in the list, when that's more than capacity only the first capacity items are stored
+            // Each item has to be a number (surrounding whitespaces are allowed), if one of them isn't typeInt or typeDouble is thrown
+            size_t toIntArray(int* out, const size_t& capacity, const char& separator=',') const throw(valueType);
+            size_t toDoubleArray(double* out, const size_t& capacity, const char& separator=',') const throw(valueType);
+            // The same as above, but store the numbers in a vector (which will be resized to the number of items)
+            void toIntArray(std::vector<int>& out, const char& separator=',') const throw(valueType);
+            void toDoubleArray(std::vector<double>& out, const char& separator=',') const throw(valueType);
+            // Set the value to a list of items, escaping the items where necessary
+            void setList(const std::vector<std::string>& items, const char& separator=',');
+            void setList(const std::vector<int>& items, const char& separator=',');
+            void setList(const std::vector<double>& items, const char& separator=',');
+
+            // Direct access to the value as it's stored, without making a copy (the data is only valid until this iniValue is changed)
+            const char* valueData() const;
+            size_t valueLength() const;
+            // Whether the name and value are stored inside this object, which is the case for most values
+            // If not, they're stored in an allocation of their own
+            bool isStoredInline() const;
+            // The size of the allocation holding the name and value, or 0 when they're stored inline
+            // The allocation has some room to grow, so it's usually a bit bigger than the name and value together
+            size_t heapSize() const;
+            // Release the room to grow of the allocation (what inferType() remembered is kept), does nothing when the name and value are stored inline
+            void shrinkToFit();
+
             // Copies the value of the other iniValue to this iniValue, ignoring the other's name
             void setValue(const iniValue& other);
             // Sets the value to the given value
@@ -112,8 +168,43 @@ namespace dini
             bool operator!=(const iniValue& other) const;
 
         private:
-            std::string strName;
-            std::string currValue;
+            // Whether the name and value are stored on the heap (instead of inside this object)
+            bool onHeap() const;
+            // Set the name (or the default name if the given name isn't valid) and value, used by the constructors
+            void init(const std::string& name, const char* value, const size_t& valueLength);
+            // Replace the name and value, reusing the current storage where possible
+            void assign(const char* name, const size_t& nameLength, const char* value, const size_t& valueLength);
+            // Replace or extend the value, keeping the name
+            void setValueData(const char* value, const size_t& length);
+            void appendValueData(const char* value, const size_t& length);
+            // Find the end of the list item starting at pos, which is either the next unescaped separator or the end of the value
+            const char* listItemEnd(const char* pos, const char& separator) const;
+            // Replace the name, and copy the value of other together with what inferType() remembered of it (other may be this object)
+            void copyValue(const char* name, const size_t& nameLength, const iniValue& other);
+            // Where inferType() keeps the number it found: the last bytes of the storage, or a null pointer if those are used by the name and value
+            char* typedSlot() const;
+
+            // What inferType() remembered, any change to the value resets this to storedNone
+            enum storedType { storedNone, storedInt, storedDouble, storedBool };
+            enum { typedSlotSize=sizeof(double) };
+
+            // The name and value are stored right after each other in one buffer
+            // When they fit in inlineCapacity characters together they're stored inside this object, which is the case for most values,
+            // if not they're stored on the heap (and onHeap() is true)
+            enum { inlineCapacity=40 };
+            // Names are never anywhere near 2^30 characters long, so the top bits of nameSize are used for the stored type
+            unsigned int nameSize : 30;
+            unsigned int typeTag : 2;
+            unsigned int valueSize;
+            union
+            {
+                char inlineData[inlineCapacity];
+                struct
+                {
+                    char* data;
+                    size_t capacity;
+                } heap;
+            } storage;
     };
 
     // Function to convert an int to a string
@@ -0,0 +1,190 @@
+#include "iniwriter.h"
+#include "dini_private.h"
+#include "dini_io.h"
+
+#include <unordered_map>
+#include <utility>
+
+namespace dini
+{
+    // Everything that's needed while a file is open, kept out of the header so it doesn't need dini_io.h
+    class iniWriter::sink
+    {
+        public:
+            sink(const std::string& filename)
+                :filename(filename), inSection(false), sections(0), values(0){}
+
+            // Check whether a value with this name was already written in the current section, and remember it if it wasn't
+            bool addName(const std::string& name, const bool& caseSensitive)
+            {
+                const unsigned int hash=diniPrivate::hashName(name.data(), name.size());
+                const std::pair<nameMap::const_iterator, nameMap::const_iterator> range=seen.equal_range(hash);
+                for(nameMap::const_iterator pos=range.first; pos!=range.second; ++pos)
+                {
+                    if(diniPrivate::sameName(names.data()+pos->second.first, pos->second.second, name.data(), name.size(), caseSensitive))
+                        return false;
+                }
+                seen.insert(std::make_pair(hash, std::make_pair(names.size(), name.size())));
+                names+=name;
+                return true;
+            }
+            // Forget the names of the current section (the memory is kept for the next section)
+            void clearNames()
+            {
+                seen.clear();
+                names.clear();
+            }
+
+            typedef std::unordered_multimap<unsigned int, std::pair<size_t, size_t> > nameMap;
+
+            diniPrivate::fileWriter file;
+            std::string filename;
+            std::string buffer;         // What's written but not yet passed on to file
+            bool inSection;             // Whether a section has been started
+            size_t sections;
+            size_t values;
+            std::string names;          // The names of the values in the current section, after each other
+            nameMap seen;               // Hash of each name in names, with its position and length in names
+    };
+
+// iniWriter
+    // Public:
+        iniWriter::iniWriter(const bool& caseSensitive)
+            :out(0), caseSensitive(caseSensitive){}
+        iniWriter::iniWriter(const std::string& filename, const bool& caseSensitive) throw(fileError)
+            :out(0), caseSensitive(caseSensitive)
+        { open(filename); }
+        iniWriter::iniWriter(const char* filename, const bool& caseSensitive) throw(fileError)
+            :out(0), caseSensitive(caseSensitive)
+        { open(filename); }
+
+        iniWriter::~iniWriter()
+        {
+            try
+            {
+                close();
+            }
+            catch(const fileError&)
+            {
+                // Nothing we can do about it here
+            }
+        }
+
+        void iniWriter::open(const std::string& filename) throw(fileError)
+        {
+            close();
+            sink* opened=new sink(filename);
+            if(opened->file.open(filename)!=diniPrivate::ioOk)
+            {
+                delete opened;
+                throw fileError(filename, fileError::openForWritingError);
+            }
+            out=opened;
+        }
+
+        bool iniWriter::isOpen() const
+        { return out!=0; }
+        bool iniWriter::isCaseSensitive() const
+        { return caseSensitive; }
+
+        bool iniWriter::beginSection(const std::string& name) throw(fileError)
+        {
+            if(!out || !diniPrivate::validName(name))
+                return false;
+
+            // End the previous section with an empty line (just like iniFile::saveToFile() does), and start the new one
+            if(out->inSection)
+                out->buffer+='\n';
+            out->buffer+='[';
+            out->buffer+=name;
+            out->buffer+="]\n";
+            out->inSection=true;
+            out->clearNames();
+            ++out->sections;
+            flush(false);
+            return true;
+        }
+
+        bool iniWriter::writeValue(const std::string& name, const iniValue& value) throw(fileError)
+        { return writeData(name, value.valueData(), value.valueLength()); }
+        bool iniWriter::writeValue(const std::string& name, const int& value) throw(fileError)
+        { return writeValue(name, intToString(value)); }
+        bool iniWriter::writeValue(const std::string& name, const double& value) throw(fileError)
+        { return writeValue(name, doubleToString(value)); }
+        bool iniWriter::writeValue(const std::string& name, const char& value) throw(fileError)
+        { return writeData(name, &value, 1); }
+        bool iniWriter::writeValue(const std::string& name, const bool& value) throw(fileError)
+        { return writeValue(name, boolToString(value)); }
+        bool iniWriter::writeValue(const std::string& name, const std::string& value) throw(fileError)
+        { return writeData(name, value.data(), value.size()); }
+        bool iniWriter::writeValue(const std::string& name, const char* value) throw(fileError)
+        { return writeData(name, value, std::char_traits<char>::length(value)); }
+
+        bool iniWriter::writeSection(const iniSection& section) throw(fileError)
+        {
+            if(!beginSection(section.name()))
+                return false;
+            // The values of a section are already unique, unless this writer isn't case sensitive while the section is
+            bool result=true;
+            for(iniSection::const_iterator pos=section.begin(); pos!=section.end(); ++pos)
+            {
+                if(!writeData(pos->name(), pos->valueData(), pos->valueLength()))
+                    result=false;
+            }
+            return result;
+        }
+
+        size_t iniWriter::sectionCount() const
+        { return out?out->sections:0; }
+        size_t iniWriter::valueCount() const
+        { return out?out->values:0; }
+
+        void iniWriter::close() throw(fileError)
+        {
+            if(!out)
+                return;
+
+            // End the last section, and write whatever is left
+            if(out->inSection)
+                out->buffer+='\n';
+            flush(true);
+            const bool closed=(out->file.close()==diniPrivate::ioOk);
+            const std::string filename=out->filename;
+            delete out;
+            out=0;
+            if(!closed)
+                throw fileError(filename, fileError::writeError);
+        }
+
+    // Private:
+        bool iniWriter::writeData(const std::string& name, const char* data, const size_t& length) throw(fileError)
+        {
+            if(!out || !out->inSection || !diniPrivate::validName(name) || !out->addName(name, caseSensitive))
+                return false;
+
+            // Write the name of the value, and then the value itself with any special characters escaped
+            out->buffer+=name;
+            out->buffer+='=';
+            diniPrivate::appendEscaped(out->buffer, data, length);
+            out->buffer+='\n';
+            ++out->values;
+            flush(false);
+            return true;
+        }
+
+        void iniWriter::flush(const bool& force) throw(fileError)
+        {
+            // The file has a large buffer of its own, but passing it many tiny pieces is slower than collecting them here first
+            if(out->buffer.empty() || (!force && out->buffer.size()<64*1024))
+                return;
+            if(out->file.write(out->buffer)!=diniPrivate::ioOk)
+            {
+                // Give up on the file, so a later close() doesn't try to write the same data again
+                const std::string filename=out->filename;
+                delete out;
+                out=0;
+                throw fileError(filename, fileError::writeError);
+            }
+            out->buffer.clear();
+        }
+}
@@ -0,0 +1,94 @@
+#ifndef INIWRITER_H
+#define INIWRITER_H
+
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* This code is under the GPLv3 license.                                                                     *
+* That means that you're free to use and edit this code,                                                    *
+* as long as you publish any changes you make using this license.                                           *
+*                                                                                                           *
+* For the full license, see gpl3.txt or gpl3.html.                                                          *
+************************************************************************************************************/
+
+#include "inifile.h"
+#include <string>
+#include <cstddef>
+
+namespace dini
+{
+    // Writes an ini file section by section and value by value, without building an iniFile first
+    // Everything is written (escaped the same way as iniFile::saveToFile() does) as soon as it's passed, through a large buffer,
+    // so only the names of the values in the current section are kept in memory (to find duplicates), no matter how big the file gets
+    // A file written using the same sections and values as an iniFile is exactly the same as the file iniFile::saveToFile() would write
+    //
+    // EXAMPLE:
+    // dini::iniWriter writer("inventory.ini");
+    // writer.beginSection("item1");
+    // writer.writeValue("count", 42);
+    // writer.writeValue("description", "A thing; with a comment character");
+    // writer.close();
+    class iniWriter
+    {
+        public:
+            // Creates a writer which isn't writing to a file yet (see open())
+            // If caseSensitive is false, value names which only differ in case are seen as duplicates (see iniFile::setCaseSensitive())
+            iniWriter(const bool& caseSensitive=true);
+            // Creates a writer and opens filename for writing (see open())
+            iniWriter(const std::string& filename, const bool& caseSensitive=true) throw(fileError);
+            // (Without this a string literal would be taken as the bool of the first constructor)
+            iniWriter(const char* filename, const bool& caseSensitive=true) throw(fileError);
+            // Closes the file if it's still open, but since a destructor can't throw, any error is lost then
+            // Call close() yourself to find out whether everything was written succesfull
+            ~iniWriter();
+
+            // Open (and truncate) filename for writing, if another file was still open it's closed first
+            void open(const std::string& filename) throw(fileError);
+            // Check whether a file is open
+            bool isOpen() const;
+            // Whether value names are case sensitive when looking for duplicates
+            bool isCaseSensitive() const;
+
+            // Start a new section, the values written after this will be put in this section
+            // Returns false (and writes nothing) if no file is open or name isn't a valid name
+            // The names of earlier sections aren't remembered, so it's up to you not to write the same section twice
+            bool beginSection(const std::string& name) throw(fileError);
+            // Write a value in the current section
+            // Returns false (and writes nothing) if no file is open, no section has been started yet, name isn't a valid name,
+            // or a value with the same name was already written in the current section
+            bool writeValue(const std::string& name, const iniValue& value) throw(fileError);
+            bool writeValue(const std::string& name, const int& value) throw(fileError);
+            bool writeValue(const std::string& name, const double& value) throw(fileError);
+            bool writeValue(const std::string& name, const char& value) throw(fileError);
+            bool writeValue(const std::string& name, const bool& value) throw(fileError);
+            bool writeValue(const std::string& name, const std::string& value) throw(fileError);
+            bool writeValue(const std::string& name, const char* value) throw(fileError);
+            // Write a whole section at once, the same as calling beginSection() and then writeValue() for each of its values
+            bool writeSection(const iniSection& section) throw(fileError);
+
+            // Get the number of sections and values written since the file was opened
+            size_t sectionCount() const;
+            size_t valueCount() const;
+
+            // Write everything that's still buffered and close the file
+            void close() throw(fileError);
+
+        private:
+            // Can't be copied
+            iniWriter(const iniWriter& other);
+            iniWriter& operator=(const iniWriter& other);
+
+            // Write a value which is already known to be valid
+            bool writeData(const std::string& name, const char* data, const size_t& length) throw(fileError);
+            // Pass the buffer on to the file if it's big enough (or always if force is true)
+            void flush(const bool& force) throw(fileError);
+
+            class sink;
+            sink* out;
+            bool caseSensitive;
+    };
+}
+
+#endif // INIWRITER_H
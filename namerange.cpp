@@ -0,0 +1,41 @@
+#include "namerange.h"
+#include "dini_private.h"
+
+namespace dini
+{
+// Functions:
+    bool globMatch(const std::string& pattern, const std::string& str, const bool& caseSensitive)
+    { return globMatch(pattern, str.data(), str.length(), caseSensitive); }
+
+    bool globMatch(const std::string& pattern, const char* str, const size_t& length, const bool& caseSensitive)
+    {
+        // Walk through both strings, remembering the last '*' we've seen so we can backtrack to it on a mismatch
+        size_t p=0, s=0;
+        size_t starPos=std::string::npos, starMatch=0;
+        while(s<length)
+        {
+            if(p<pattern.length() && (pattern[p]=='?' || pattern[p]==str[s] || (!caseSensitive && diniPrivate::foldCase(pattern[p])==diniPrivate::foldCase(str[s]))))
+            {
+                p++;
+                s++;
+            }
+            else if(p<pattern.length() && pattern[p]=='*')
+            {
+                starPos=p++;
+                starMatch=s;
+            }
+            else if(starPos!=std::string::npos)
+            {
+                // Let the last '*' match one more character and try again from there
+                p=starPos+1;
+                s=++starMatch;
+            }
+            else
+                return false;
+        }
+        // Any '*' left at the end of the pattern can match the empty string
+        while(p<pattern.length() && pattern[p]=='*')
+            p++;
+        return p==pattern.length();
+    }
+}
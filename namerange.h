@@ -0,0 +1,229 @@
+#ifndef NAMERANGE_H
+#define NAMERANGE_H
+
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* This code is under the GPLv3 license.                                                                     *
+* That means that you're free to use and edit this code,                                                    *
+* as long as you publish any changes you make using this license.                                           *
+*                                                                                                           *
+* For the full license, see gpl3.txt or gpl3.html.                                                          *
+************************************************************************************************************/
+
+#include <string>
+#include <vector>
+#include <iterator>
+#include <type_traits>
+#include <cstddef>
+
+namespace dini
+{
+    // Checks whether str matches the glob pattern, where '*' matches any sequence of characters and '?' matches exactly one character
+    // When caseSensitive is false, letters match regardless of their case
+    bool globMatch(const std::string& pattern, const std::string& str, const bool& caseSensitive=true);
+    bool globMatch(const std::string& pattern, const char* str, const size_t& length, const bool& caseSensitive=true);
+
+    // Iterator over the items of a vector which skips the items marked as erased (see iniSection::setEraseLimit()), erased is a null pointer when none are marked
+    // This is the iterator and const_iterator of iniFile and iniSection, the non-const iterators remove the marked items first, so only a const_iterator ever has to skip
+    // Random access is constant time when nothing is marked, otherwise jumping and measuring distances walks over the items in between
+    // T is iniSection or iniValue, possibly const
+    template<class T> class liveIterator
+    {
+        public:
+            typedef std::random_access_iterator_tag iterator_category;
+            typedef T value_type;
+            typedef std::ptrdiff_t difference_type;
+            typedef T* pointer;
+            typedef T& reference;
+
+            liveIterator()
+                :item(0), first(0), last(0), erased(0){}
+            liveIterator(T* items, const size_t& pos, const size_t& count, const std::vector<bool>* erased)
+                :item(items+pos), first(items), last(items+count), erased(erased)
+            { skip(); }
+            // Converts an iterator to a const_iterator
+            template<class U> liveIterator(const liveIterator<U>& other, typename std::enable_if<std::is_convertible<U*, T*>::value>::type* =0)
+                :item(other.item), first(other.first), last(other.last), erased(other.erased){}
+
+            T& operator*() const
+            { return *item; }
+            T* operator->() const
+            { return item; }
+            T& operator[](const difference_type& n) const
+            { return *(*this+n); }
+
+            liveIterator& operator++()
+            { ++item; skip(); return *this; }
+            liveIterator operator++(int)
+            { liveIterator out=*this; ++*this; return out; }
+            liveIterator& operator--()
+            {
+                do
+                    --item;
+                while(erased && (*erased)[item-first]);
+                return *this;
+            }
+            liveIterator operator--(int)
+            { liveIterator out=*this; --*this; return out; }
+
+            liveIterator& operator+=(difference_type n)
+            {
+                if(!erased)
+                    item+=n;
+                else
+                {
+                    for(; n>0; --n)
+                        ++*this;
+                    for(; n<0; ++n)
+                        --*this;
+                }
+                return *this;
+            }
+            liveIterator& operator-=(const difference_type& n)
+            { return *this+=-n; }
+            liveIterator operator+(const difference_type& n) const
+            { liveIterator out=*this; return out+=n; }
+            friend liveIterator operator+(const difference_type& n, const liveIterator& pos)
+            { return pos+n; }
+            liveIterator operator-(const difference_type& n) const
+            { liveIterator out=*this; return out+=-n; }
+
+            // The number of live items between other and this iterator
+            difference_type operator-(const liveIterator& other) const
+            {
+                if(!erased)
+                    return item-other.item;
+                const T* from=(item<other.item ? item : other.item);
+                const T* to=(item<other.item ? other.item : item);
+                difference_type out=0;
+                for(; from!=to; ++from)
+                {
+                    if(!(*erased)[from-first])
+                        ++out;
+                }
+                return item<other.item ? -out : out;
+            }
+
+        private:
+            template<class U> friend class liveIterator;
+
+            // Skip the marked items
+            void skip()
+            {
+                if(erased)
+                {
+                    while(item!=last && (*erased)[item-first])
+                        ++item;
+                }
+            }
+
+            T* item;
+            T* first;
+            T* last;
+            const std::vector<bool>* erased;
+    };
+
+    // Comparisons, an iterator can be compared with a const_iterator
+    template<class T, class U> bool operator==(const liveIterator<T>& a, const liveIterator<U>& b)
+    { return a.operator->()==b.operator->(); }
+    template<class T, class U> bool operator!=(const liveIterator<T>& a, const liveIterator<U>& b)
+    { return a.operator->()!=b.operator->(); }
+    template<class T, class U> bool operator<(const liveIterator<T>& a, const liveIterator<U>& b)
+    { return a.operator->()<b.operator->(); }
+    template<class T, class U> bool operator>(const liveIterator<T>& a, const liveIterator<U>& b)
+    { return b<a; }
+    template<class T, class U> bool operator<=(const liveIterator<T>& a, const liveIterator<U>& b)
+    { return !(b<a); }
+    template<class T, class U> bool operator>=(const liveIterator<T>& a, const liveIterator<U>& b)
+    { return !(a<b); }
+
+    // A range of sections or values, as returned by the prefix and pattern queries of iniFile, iniSection and iniSnapshot::section
+    // The range is a view on the container it was taken from, so it's only valid until that container is changed
+    // T is either iniSection or iniValue, possibly const, or const iniSnapshot::value, and Index is the type of the positions in the sorted index
+    template<class T, class Index=size_t> class nameRange
+    {
+        public:
+            // Forward iterator over the items in the range, ordered by name
+            class iterator
+            {
+                public:
+                    typedef std::forward_iterator_tag iterator_category;
+                    typedef T value_type;
+                    typedef std::ptrdiff_t difference_type;
+                    typedef T* pointer;
+                    typedef T& reference;
+
+                    iterator()
+                        :items(0), pos(0), last(0), caseSensitive(true), erased(0){}
+
+                    T& operator*() const
+                    { return items[*pos]; }
+                    T* operator->() const
+                    { return &items[*pos]; }
+
+                    iterator& operator++()
+                    { ++pos; skip(); return *this; }
+                    iterator operator++(int)
+                    { iterator out=*this; ++*this; return out; }
+
+                    bool operator==(const iterator& other) const
+                    { return pos==other.pos; }
+                    bool operator!=(const iterator& other) const
+                    { return pos!=other.pos; }
+
+                private:
+                    friend class nameRange;
+
+                    iterator(T* items, const Index* pos, const Index* last, const std::string& pattern, const bool& caseSensitive, const std::vector<bool>* erased)
+                        :items(items), pos(pos), last(last), pattern(pattern), caseSensitive(caseSensitive), erased(erased)
+                    { skip(); }
+
+                    // Skip all items which are marked as erased or don't match the pattern (if there is one)
+                    void skip()
+                    {
+                        while(pos!=last && ((erased && (*erased)[*pos]) ||
+                                            (!pattern.empty() && !globMatch(pattern, items[*pos].nameData(), items[*pos].nameLength(), caseSensitive))))
+                            ++pos;
+                    }
+
+                    T* items;
+                    const Index* pos;
+                    const Index* last;
+                    std::string pattern;
+                    bool caseSensitive;
+                    const std::vector<bool>* erased;
+            };
+            typedef iterator const_iterator;
+
+            // The items marked in erased are left out (when it isn't a null pointer)
+            nameRange(T* items, const Index* first, const Index* last, const std::string& pattern="", const bool& caseSensitive=true, const std::vector<bool>* erased=0)
+                :items(items), first(first), last(last), pattern(pattern), caseSensitive(caseSensitive), erased(erased){}
+
+            // Get iterator to the beginning of the range
+            iterator begin() const
+            { return iterator(items, first, last, pattern, caseSensitive, erased); }
+            // Get iterator to the end of the range
+            iterator end() const
+            { return iterator(items, last, last, "", caseSensitive, 0); }
+
+            // Check whether the range is empty
+            bool empty() const
+            { return begin()==end(); }
+            // Count the number of items in the range
+            size_t size() const
+            { return pattern.empty() && !erased ? static_cast<size_t>(last-first) : static_cast<size_t>(std::distance(begin(), end())); }
+
+        private:
+            T* items;
+            const Index* first;
+            const Index* last;
+            std::string pattern;
+            bool caseSensitive;
+            const std::vector<bool>* erased;
+    };
+}
+
+#endif // NAMERANGE_H
@@ -0,0 +1,56 @@
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* Runs all tests of dini, the exit code is 0 when all of them pass                                          *
+************************************************************************************************************/
+
+#include "test.h"
+#include <iostream>
+
+using namespace std;
+
+namespace
+{
+    int failed=0;
+}
+
+bool checkCondition(const bool& condition, const char* text, const char* file, const int& line)
+{
+    if(!condition)
+    {
+        cerr<<file<<':'<<line<<": check failed: "<<text<<endl;
+        failed++;
+    }
+    return condition;
+}
+
+int failedChecks()
+{ return failed; }
+
+int main()
+{
+    // Run the tests one by one, and tell which of them failed
+    struct test
+    {
+        const char* name;
+        void (*run)();
+    };
+    const test tests[]={
+        { "value", testValue },
+        { "io", testIo },
+        { "access", testAccess },
+        { "snapshot", testSnapshot }
+    };
+    int failedTests=0;
+    for(size_t i=0; i<sizeof(tests)/sizeof(tests[0]); i++)
+    {
+        const int before=failed;
+        tests[i].run();
+        cout<<tests[i].name<<": "<<(failed==before ? "passed" : "FAILED")<<endl;
+        if(failed!=before)
+            failedTests++;
+    }
+    return failedTests==0 ? 0 : 1;
+}
@@ -0,0 +1,26 @@
+#ifndef TEST_H
+#define TEST_H
+
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* Helpers for the tests of dini                                                                             *
+************************************************************************************************************/
+
+// Check a condition, a check that fails is printed (with the file and line it's on), and makes the whole run fail
+// The test goes on after a failed check, so all failures of a test are shown at once
+#define CHECK(condition) checkCondition((condition), #condition, __FILE__, __LINE__)
+
+// Count and print a failed check, returns condition
+bool checkCondition(const bool& condition, const char* text, const char* file, const int& line);
+// Get the number of failed checks so far
+int failedChecks();
+
+// The tests, each in a file of its own
+void testValue();
+void testIo();
+void testAccess();
+void testSnapshot();
+#endif // TEST_H
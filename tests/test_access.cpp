@@ -0,0 +1,83 @@
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* Tests of access counting, and of reusing the counters of values that are gone                             *
+************************************************************************************************************/
+
+#include "test.h"
+#include "dini.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace dini;
+
+namespace
+{
+    // Get the number of lookups of a value (or of the section itself when name is empty), or -1 if it isn't counted
+    long long countOf(const iniFile& file, const string& section, const string& name)
+    {
+        const vector<accessCount> counts=file.accessCounts();
+        for(vector<accessCount>::const_iterator count=counts.begin(); count!=counts.end(); ++count)
+        {
+            if(count->section==section && count->name==name)
+                return static_cast<long long>(count->count);
+        }
+        return -1;
+    }
+}
+
+void testAccess()
+{
+    iniFile file;
+    for(int value=0; value<10; value++)
+        file["a"].setValue("v"+to_string(value), value);
+    CHECK(file.accessCounts().empty());
+
+    // Lookups are counted per section and value, setting a value isn't
+    file.setAccessCounting(true);
+    file["a"]["v1"].toInt();
+    file.getSection("a").getValue("v1");
+    file.tryGetSection("a")->tryGetValue("v2");
+    file["a"].setValue("v3", 3);
+    CHECK(countOf(file, "a", "")==4 && countOf(file, "a", "v1")==2 && countOf(file, "a", "v2")==1 && countOf(file, "a", "v3")==0);
+    CHECK(file.unreadKeys().size()==8 && file.hottestKeys(1).size()==1 && file.hottestKeys(1)[0].name=="v1");
+
+    // A copy counts in the same counters, but keeps them when the section is replaced, which starts the new values at 0
+    {
+        const iniSection copy=file.getSection("a");
+        copy.getValue("v2");
+        CHECK(countOf(file, "a", "v2")==2);
+        iniSection replacement("b");
+        replacement.setValue("v2", 2);
+        file.setSection("a", replacement);
+        CHECK(countOf(file, "a", "v2")==0);
+        copy.getValue("v2");
+        CHECK(countOf(file, "a", "v2")==0);
+    }
+
+    // The counters of values that are gone are used again, so replacing values over and over doesn't keep adding counters
+    accessCounter counter;
+    const size_t first=counter.addSlot();
+    counter.count(first);
+    counter.retain(first);
+    counter.release(first);
+    CHECK(counter.total(first)==1);
+    counter.release(first);
+    CHECK(counter.addSlot()==first && counter.total(first)==0 && counter.slotCount()==1);
+    for(int round=0; round<1000; round++)
+    {
+        vector<size_t> slots;
+        for(int i=0; i<10; i++)
+            slots.push_back(counter.addSlot());
+        counter.release(slots);
+    }
+    CHECK(counter.slotCount()==11);
+
+    // Turning counting off forgets all counts
+    file.setAccessCounting(false);
+    file["a"]["v2"];
+    CHECK(file.accessCounts().empty() && file.unreadKeys().empty());
+}
@@ -0,0 +1,113 @@
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* Tests of reading and writing whole files, with io_uring and with the plain system calls it falls back to  *
+************************************************************************************************************/
+
+#include "test.h"
+#include "dini.h"
+#include "dini_io.h"
+#include <string>
+#include <cstdio>
+
+#if defined(DINI_USE_IO_URING) && defined(__linux__)
+    #define TEST_IO_FALLBACK
+    #include <cerrno>
+    #include <cstddef>
+    #include <unistd.h>
+    #include <sys/wait.h>
+    #include <sys/prctl.h>
+    #include <sys/syscall.h>
+    #include <linux/filter.h>
+    #include <linux/seccomp.h>
+#endif
+
+using namespace std;
+using namespace dini;
+
+namespace
+{
+    const size_t chunk=1<<20;       // The size of a read or write of dini_io.cpp, the sizes below are around it
+
+    // Write and read back files of sizes around the chunk size (in pieces of an odd size, so the buffers fill up unevenly),
+    // and save and load a file, which has to give the same contents
+    void checkFiles()
+    {
+        const string path="dini_test_io.tmp";
+        const size_t sizes[]={0, 1, 4095, chunk-1, chunk, chunk+1, 3*chunk+17, 10*chunk+5};
+        for(size_t i=0; i<sizeof(sizes)/sizeof(sizes[0]); i++)
+        {
+            string data(sizes[i], ' ');
+            for(size_t pos=0; pos<data.size(); pos++)
+                data[pos]=static_cast<char>('a'+(pos*7+pos/4093)%26);
+            diniPrivate::fileWriter writer;
+            CHECK(writer.open(path)==diniPrivate::ioOk);
+            for(size_t pos=0; pos<data.size(); pos+=12347)
+                CHECK(writer.write(data.data()+pos, min<size_t>(12347, data.size()-pos))==diniPrivate::ioOk);
+            CHECK(writer.close()==diniPrivate::ioOk);
+            string read="left over";
+            CHECK(diniPrivate::readWholeFile(path, read)==diniPrivate::ioOk);
+            CHECK(read==data);
+        }
+
+        iniFile file;
+        for(int section=0; section<200; section++)
+        {
+            for(int value=0; value<100; value++)
+                file["section"+to_string(section)].setValue("value"+to_string(value), string(value, 'x')+to_string(section));
+        }
+        file.saveToFile(path);
+        iniFile loaded;
+        loaded.loadFromFile(path);
+        CHECK(loaded.fingerprint()==file.fingerprint());
+        remove(path.c_str());
+
+        // Files which can't be opened
+        string read;
+        CHECK(diniPrivate::readWholeFile("dini_test_missing/file.ini", read)==diniPrivate::ioOpenError && read.empty());
+        diniPrivate::fileWriter writer;
+        CHECK(writer.open("dini_test_missing/file.ini")==diniPrivate::ioOpenError);
+#ifdef __linux__
+        // Files of which the size isn't known beforehand are read completely as well
+        CHECK(diniPrivate::readWholeFile("/proc/self/status", read)==diniPrivate::ioOk && read.find("Name:")!=string::npos);
+#endif
+    }
+
+#ifdef TEST_IO_FALLBACK
+    // Check the files again in a child process in which io_uring_setup() fails with ENOSYS, as it does on kernels without io_uring
+    // (or in containers which don't allow it), so everything has to fall back to read() and write()
+    void checkFallback()
+    {
+        const pid_t child=fork();
+        if(child==0)
+        {
+            sock_filter filter[]={
+                BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(seccomp_data, nr)),
+                BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_io_uring_setup, 0, 1),
+                BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ENOSYS),
+                BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW)
+            };
+            sock_fprog program={ static_cast<unsigned short>(sizeof(filter)/sizeof(filter[0])), filter };
+            if(prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0)!=0 || prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &program)!=0)
+                _exit(2);
+            const int before=failedChecks();
+            CHECK(syscall(__NR_io_uring_setup, 1, 0)<0 && errno==ENOSYS);
+            checkFiles();
+            _exit(failedChecks()==before ? 0 : 1);
+        }
+        int status=0;
+        CHECK(child>0 && waitpid(child, &status, 0)==child);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status)==0);
+    }
+#endif
+}
+
+void testIo()
+{
+    checkFiles();
+#ifdef TEST_IO_FALLBACK
+    checkFallback();
+#endif
+}
@@ -0,0 +1,125 @@
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* Tests of snapshots: publishing and attaching them, their generations, and rejecting damaged files         *
+************************************************************************************************************/
+
+#include "test.h"
+#include "dini.h"
+#include <string>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+
+using namespace std;
+using namespace dini;
+
+namespace
+{
+    const string path="dini_test_snapshot.tmp";
+    const string damagedPath="dini_test_snapshot_damaged.tmp";
+
+    string readFile(const string& filename)
+    {
+        ifstream in(filename.c_str(), ios::binary);
+        return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+    void writeFile(const string& filename, const string& data)
+    {
+        ofstream out(filename.c_str(), ios::binary | ios::trunc);
+        out.write(data.data(), data.size());
+    }
+
+    // Try to attach to a snapshot with the given contents, returns true if it's rejected with a readError
+    // When it's accepted, every section and value is read and looked up by name, which may not read outside of the snapshot (the sanitizers catch that)
+    bool rejected(const string& data)
+    {
+        writeFile(damagedPath, data);
+        iniSnapshot snapshot;
+        try
+        {
+            snapshot.attach(damagedPath);
+        }
+        catch(fileError& error)
+        {
+            return error.type==fileError::readError;
+        }
+        for(size_t pos=0; pos<snapshot.size(); pos++)
+        {
+            const iniSnapshot::section section=snapshot.sectionAt(pos);
+            snapshot.sectionExists(section.name());
+            for(iniSnapshot::section::const_iterator value=section.begin(); value!=section.end(); ++value)
+            {
+                int number;
+                section.valueExists(value->name());
+                value->toString();
+                value->tryToInt(number);
+            }
+        }
+        return false;
+    }
+}
+
+void testSnapshot()
+{
+    iniFile file;
+    for(int section=0; section<20; section++)
+    {
+        for(int value=0; value<10; value++)
+            file["s"+to_string(section)].setValue("v"+to_string(value), section*100+value);
+    }
+    file["text"]["multiline"]="a;b=c\nd";
+    remove(path.c_str());
+
+    // Publish and attach, the snapshot has the same sections and values
+    iniSnapshot::publish(file, path);
+    iniSnapshot first;
+    first.attach(path);
+    CHECK(first.generation()==1 && !first.isStale());
+    CHECK(first.size()==21 && first.sectionAt(20).name()=="text");
+    CHECK(first["s7"]["v3"].toInt()==703 && first["text"]["multiline"].toString()=="a;b=c\nd");
+    CHECK(!first.sectionExists("s20") && first["s0"].tryGetValue("v10")==0);
+    CHECK(first.toIniFile().fingerprint()==file.fingerprint());
+
+    // Publishing again makes a new generation, the old one stays readable and knows it's stale
+    file["s7"]["v3"]=-1;
+    iniSnapshot::publish(file, path);
+    CHECK(first.isStale() && first["s7"]["v3"].toInt()==703);
+    iniSnapshot second;
+    second.attach(path);
+    CHECK(second.generation()==2 && !second.isStale() && second["s7"]["v3"].toInt()==-1);
+    iniSnapshot::publish(file, path);
+    CHECK(second.isStale());
+    second.attach(path);
+    CHECK(second.generation()==3 && !second.isStale());
+    CHECK(!iniSnapshot(file).isStale());
+
+    // A truncated snapshot is rejected
+    const string data=readFile(path);
+    CHECK(!rejected(data));
+    const size_t lengths[]={0, 1, 7, 64, data.size()/2, data.size()-1};
+    for(size_t i=0; i<sizeof(lengths)/sizeof(lengths[0]); i++)
+        CHECK(rejected(data.substr(0, lengths[i])));
+    CHECK(rejected(data+'x'));
+
+    // A flipped byte in the magic, version or size of the header, or in the top of a table offset, is rejected
+    // A flipped byte anywhere else is either rejected, or gives a snapshot which can be read safely (the names and values may be wrong)
+    const size_t headerBytes[]={0, 3, 7, 8, 11, 24, 31, 47, 55, 63};
+    for(size_t i=0; i<sizeof(headerBytes)/sizeof(headerBytes[0]); i++)
+    {
+        string damaged=data;
+        damaged[headerBytes[i]]^=static_cast<char>(0x80);
+        CHECK(rejected(damaged));
+    }
+    for(size_t pos=0; pos<data.size(); pos++)
+    {
+        string damaged=data;
+        damaged[pos]^=static_cast<char>(0xff);
+        rejected(damaged);
+    }
+
+    remove(path.c_str());
+    remove(damagedPath.c_str());
+}
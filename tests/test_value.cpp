@@ -0,0 +1,98 @@
+/************************************************** Info: ***************************************************
+* Author:     Divendo                                                                                       *
+* Version:    1.1                                                                                           *
+* Website:    http://divendo-webs.com                                                                       *
+*                                                                                                           *
+* Tests of how iniValue stores its name and value (inline or on the heap), and of reading them in place    *
+************************************************************************************************************/
+
+#include "test.h"
+#include "dini.h"
+#include <string>
+
+using namespace std;
+using namespace dini;
+
+namespace
+{
+    // Check that value has the given name and value, and converts the same way as a value stored the other way
+    void checkValue(const iniValue& value, const string& name, const string& data)
+    {
+        CHECK(value.name()==name && value.nameLength()==name.length() && string(value.nameData(), value.nameLength())==name);
+        CHECK(value.toString()==data && value.valueLength()==data.length() && string(value.valueData(), value.valueLength())==data);
+    }
+}
+
+void testValue()
+{
+    // Short names and values are kept inside the object, which is smaller than the two strings it used to hold
+    CHECK(sizeof(iniValue)<2*sizeof(string));
+    const iniValue small("key", "value");
+    CHECK(small.isStoredInline() && small.heapSize()==0);
+    checkValue(small, "key", "value");
+
+    // Long ones get one allocation for both
+    const string longName(60, 'n'), longData(200, 'd');
+    iniValue big(longName, longData);
+    CHECK(!big.isStoredInline() && big.heapSize()>=longName.length()+longData.length());
+    checkValue(big, longName, longData);
+
+    // Copies are independent, whichever way they're stored
+    iniValue copy(big);
+    copy.setValue("changed");
+    checkValue(big, longName, longData);
+    checkValue(copy, longName, "changed");
+    iniValue smallCopy(small);
+    smallCopy=longData;
+    checkValue(small, "key", "value");
+    checkValue(smallCopy, "key", longData);
+    smallCopy=smallCopy;
+    checkValue(smallCopy, "key", longData);
+
+    // Growing and shrinking the name or value moves them between the object and the heap, keeping the other one
+    iniValue moving("a", "1");
+    moving.setValue(longData);
+    checkValue(moving, "a", longData);
+    moving.setValue("2");
+    checkValue(moving, "a", "2");
+    CHECK(moving.setName(longName));
+    checkValue(moving, longName, "2");
+    moving.shrinkToFit();
+    checkValue(moving, longName, "2");
+    CHECK(moving.setName("b"));
+    checkValue(moving, "b", "2");
+
+    // Numbers are parsed from where they're stored, which gives the same results either way
+    const char* numbers[]={"42", "-7", "3.25", "1e3", "12 apples", "true", "no number", ""};
+    for(size_t i=0; i<sizeof(numbers)/sizeof(numbers[0]); i++)
+    {
+        iniValue inlined("n", numbers[i]), onHeap(longName, numbers[i]);
+        CHECK(inlined.isStoredInline() && !onHeap.isStoredInline());
+        int int1=0, int2=0;
+        double double1=0, double2=0;
+        bool bool1=false, bool2=false;
+        CHECK(inlined.tryToInt(int1)==onHeap.tryToInt(int2) && int1==int2);
+        CHECK(inlined.tryToDouble(double1)==onHeap.tryToDouble(double2) && double1==double2);
+        CHECK(inlined.tryToBool(bool1)==onHeap.tryToBool(bool2) && bool1==bool2);
+        // What inferType() remembers gives the same as parsing the value again
+        iniValue inferred(inlined);
+        inferred.inferType();
+        int1=int2=0;
+        CHECK(inferred.tryToInt(int1)==inlined.tryToInt(int2) && int1==int2);
+        checkValue(inferred, "n", numbers[i]);
+    }
+    CHECK(iniValue("n", "12 apples").toInt()==12 && iniValue(longName, "3.25").toDouble()==3.25);
+
+    // Lookups compare the stored names in place, for short and long names and in both case modes
+    iniSection section("section");
+    for(int i=0; i<50; i++)
+    {
+        const string number=to_string(i);
+        section.setValue("key"+number, i);
+        section.setValue(longName+number, i);
+    }
+    CHECK(section.getValue("key17").toInt()==17 && section.getValue(longName+"33").toInt()==33);
+    CHECK(!section.valueExists("KEY17") && !section.valueExists(longName));
+    section.setCaseSensitive(false);
+    CHECK(section.valueExists("KEY17") && section.getValue(string(60, 'N')+"5").toInt()==5);
+}
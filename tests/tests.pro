@@ -0,0 +1,27 @@
+#-------------------------------------------------
+#
+# Tests of dini, "make test" in the build of dini.pro builds and runs them
+#
+#-------------------------------------------------
+
+QT       -= core gui
+
+TARGET = tests
+CONFIG   += console c++11
+CONFIG   -= app_bundle
+
+TEMPLATE = app
+
+
+SOURCES += main.cpp \
+    test_value.cpp \
+    test_io.cpp \
+    test_access.cpp \
+    test_snapshot.cpp
+
+HEADERS += test.h
+
+include(../dini.pri)
+
+# The io test checks io_uring, and the plain system calls it falls back to when io_uring isn't available
+linux: DEFINES += DINI_USE_IO_URING